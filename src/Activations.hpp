@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "Config.hpp"
+#include "Simd.hpp"
+
+// Activation policies for `BasicControlNetwork`. Each one provides a scalar and a vector `Apply`,
+// the scalar `Derivative` at a pre-activation (for backpropagation) and its `Name`, which is written to the checkpoint header.
+// Templates over `T` are instantiated with both `FP` and `FPVec`, so both paths compute the same approximation.
+
+template <class T>
+inline T ActivationClamp(T x, FP lo, FP hi) {
+    x = x < lo ? T {} + lo : x;
+    return x > hi ? T {} + hi : x;
+}
+
+struct LeakyReLUActivation {
+    static constexpr ActivationKind Kind = ActivationKind::LeakyReLU;
+    static constexpr std::string_view Name = "leaky-relu";
+    static constexpr FP Slope = 0.1;
+
+    template <class T>
+    static T Apply(T x) {
+        return x < 0.0 ? Slope * x : x;
+    }
+
+    static FP Derivative(FP x) {
+        return x < 0.0 ? Slope : 1.0;
+    }
+};
+
+// Padé (7, 6) approximant of tanh clamped to ±4.97, absolute error below 1e-4.
+struct FastTanhActivation {
+    static constexpr ActivationKind Kind = ActivationKind::FastTanh;
+    static constexpr std::string_view Name = "fast-tanh";
+    static constexpr FP Limit = 4.97;
+
+    template <class T>
+    static T Apply(T x) {
+        x = ActivationClamp(x, -Limit, Limit);
+        T x2 = x * x;
+        T num = x * (135135.0 + x2 * (17325.0 + x2 * (378.0 + x2)));
+        T den = 135135.0 + x2 * (62370.0 + x2 * (3150.0 + x2 * 28.0));
+        return ActivationClamp(num / den, -1.0, 1.0);
+    }
+
+    static FP Derivative(FP x) {
+        if (std::abs(x) >= Limit) return 0.0;
+        FP y = Apply(x);
+        return 1.0 - y * y;
+    }
+};
+
+struct FastSigmoidActivation {
+    static constexpr ActivationKind Kind = ActivationKind::FastSigmoid;
+    static constexpr std::string_view Name = "fast-sigmoid";
+
+    template <class T>
+    static T Apply(T x) {
+        return 0.5 + 0.5 * FastTanhActivation::Apply(0.5 * x);
+    }
+
+    static FP Derivative(FP x) {
+        return 0.25 * FastTanhActivation::Derivative(0.5 * x);
+    }
+};
+
+struct CbrtActivation {
+    static constexpr ActivationKind Kind = ActivationKind::Cbrt;
+    static constexpr std::string_view Name = "cbrt";
+
+    static FP Apply(FP x) {
+        return std::cbrt(x);
+    }
+
+    // Unbounded at zero, capped so a single neuron can't blow up a gradient step.
+    static FP Derivative(FP x) {
+        FP y = std::cbrt(x);
+        return std::min(1.0 / (3.0 * y * y), 1e3);
+    }
+
+    // Exponent divided by three through the bit pattern (Kahan's initial guess), then four Newton steps
+    // take the ~6% initial error below double precision.
+    static FPVec Apply(FPVec x) {
+        using Bits = std::conditional_t<sizeof(FP) == 8, int64_t, int32_t>;
+        using BitsVec = Bits __attribute__((vector_size(SimdBytes)));
+        constexpr Bits magic = sizeof(FP) == 8 ? (Bits) 0x2A9F7893 << 32 : (Bits) 0x2A5137A0;
+
+        FPVec a = x < 0.0 ? -x : x;
+
+        BitsVec bits = std::bit_cast<BitsVec>(a);
+        FPVec third = __builtin_convertvector(bits, FPVec) * (1.0 / 3.0);
+        bits = __builtin_convertvector(third, BitsVec) + magic;
+
+        FPVec y = std::bit_cast<FPVec>(bits);
+
+        for (int i = 0; i < 4; i++) y = y - (y * y * y - a) / (3.0 * y * y);
+
+        y = a == 0.0 ? FPVec {} : y;
+        return x < 0.0 ? -y : y;
+    }
+};
+
+template <ActivationKind Kind>
+struct ActivationPolicyFor;
+
+template <> struct ActivationPolicyFor<ActivationKind::LeakyReLU> { using Type = LeakyReLUActivation; };
+template <> struct ActivationPolicyFor<ActivationKind::FastTanh> { using Type = FastTanhActivation; };
+template <> struct ActivationPolicyFor<ActivationKind::FastSigmoid> { using Type = FastSigmoidActivation; };
+template <> struct ActivationPolicyFor<ActivationKind::Cbrt> { using Type = CbrtActivation; };
+
+template <ActivationKind Kind>
+using ActivationPolicy = typename ActivationPolicyFor<Kind>::Type;
+
+// Applies the activation to `count` contiguous values, a vector at a time.
+template <class Activation>
+inline void ApplyActivation(FP* values, int count) {
+    int i = 0;
+    for (; i + SimdWidth <= count; i += SimdWidth) {
+        SimdStore(values + i, Activation::Apply(SimdLoad(values + i)));
+    }
+    for (; i < count; i++) values[i] = Activation::Apply(values[i]);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "FPType.hpp"
+
+// Reverse-mode automatic differentiation. Every operation on `AutodiffVar` appends a node with the local
+// derivatives towards its (at most two) operands to the thread's active tape; `Backward` then propagates
+// adjoints from an output to every node in one reverse sweep.
+class AutodiffTape {
+    public:
+        struct Node {
+            int A;
+            int B;
+            FP DA;
+            FP DB;
+        };
+
+        int Push(int a, FP da, int b = -1, FP db = 0.0) {
+            Nodes.push_back({a, b, da, db});
+            return (int) Nodes.size() - 1;
+        }
+
+        int Variable() {
+            return Push(-1, 0.0);
+        }
+
+        void Clear() {
+            Nodes.clear();
+        }
+
+        size_t Size() const {
+            return Nodes.size();
+        }
+
+        // Fills `adjoints` (one per node) with d(output)/d(node).
+        void Backward(int output, std::vector<FP>& adjoints) const {
+            adjoints.assign(Nodes.size(), 0.0);
+            adjoints[output] = 1.0;
+
+            for (int i = output; i >= 0; i--) {
+                FP adjoint = adjoints[i];
+                if (adjoint == 0.0) continue;
+
+                const Node& node = Nodes[i];
+                if (node.A >= 0) adjoints[node.A] += adjoint * node.DA;
+                if (node.B >= 0) adjoints[node.B] += adjoint * node.DB;
+            }
+        }
+
+        // Tape that new `AutodiffVar` operations record into.
+        static AutodiffTape*& Active() {
+            thread_local AutodiffTape* tape = nullptr;
+            return tape;
+        }
+
+    private:
+        std::vector<Node> Nodes;
+};
+
+// Scalar tracked on the active tape. Constants (`Index == -1`) are not recorded.
+struct AutodiffVar {
+    FP Value = 0.0;
+    int Index = -1;
+
+    AutodiffVar() = default;
+    AutodiffVar(FP value) : Value(value) { }
+    AutodiffVar(FP value, int index) : Value(value), Index(index) { }
+
+    static AutodiffVar Independent(FP value) {
+        return {value, AutodiffTape::Active()->Variable()};
+    }
+
+    // Result of a unary operation with local derivative `d`.
+    static AutodiffVar Unary(const AutodiffVar& a, FP value, FP d) {
+        if (a.Index < 0) return value;
+        return {value, AutodiffTape::Active()->Push(a.Index, d)};
+    }
+
+    static AutodiffVar Binary(const AutodiffVar& a, FP da, const AutodiffVar& b, FP db, FP value) {
+        if (a.Index < 0) return Unary(b, value, db);
+        if (b.Index < 0) return Unary(a, value, da);
+        return {value, AutodiffTape::Active()->Push(a.Index, da, b.Index, db)};
+    }
+};
+
+inline AutodiffVar operator +(const AutodiffVar& a, const AutodiffVar& b) { return AutodiffVar::Binary(a, 1.0, b, 1.0, a.Value + b.Value); }
+inline AutodiffVar operator -(const AutodiffVar& a, const AutodiffVar& b) { return AutodiffVar::Binary(a, 1.0, b, -1.0, a.Value - b.Value); }
+inline AutodiffVar operator *(const AutodiffVar& a, const AutodiffVar& b) { return AutodiffVar::Binary(a, b.Value, b, a.Value, a.Value * b.Value); }
+inline AutodiffVar operator /(const AutodiffVar& a, const AutodiffVar& b) {
+    FP inv = 1.0 / b.Value;
+    return AutodiffVar::Binary(a, inv, b, -a.Value * inv * inv, a.Value / b.Value);
+}
+inline AutodiffVar operator -(const AutodiffVar& a) { return AutodiffVar::Unary(a, -a.Value, -1.0); }
+
+inline AutodiffVar operator +(const AutodiffVar& a, FP b) { return AutodiffVar::Unary(a, a.Value + b, 1.0); }
+inline AutodiffVar operator +(FP a, const AutodiffVar& b) { return AutodiffVar::Unary(b, a + b.Value, 1.0); }
+inline AutodiffVar operator -(const AutodiffVar& a, FP b) { return AutodiffVar::Unary(a, a.Value - b, 1.0); }
+inline AutodiffVar operator -(FP a, const AutodiffVar& b) { return AutodiffVar::Unary(b, a - b.Value, -1.0); }
+inline AutodiffVar operator *(const AutodiffVar& a, FP b) { return AutodiffVar::Unary(a, a.Value * b, b); }
+inline AutodiffVar operator *(FP a, const AutodiffVar& b) { return AutodiffVar::Unary(b, a * b.Value, a); }
+inline AutodiffVar operator /(const AutodiffVar& a, FP b) { return AutodiffVar::Unary(a, a.Value / b, 1.0 / b); }
+
+inline AutodiffVar& operator +=(AutodiffVar& a, const AutodiffVar& b) { return a = a + b; }
+inline AutodiffVar& operator -=(AutodiffVar& a, const AutodiffVar& b) { return a = a - b; }
+
+inline bool operator <(const AutodiffVar& a, const AutodiffVar& b) { return a.Value < b.Value; }
+inline bool operator >(const AutodiffVar& a, const AutodiffVar& b) { return a.Value > b.Value; }
+inline bool operator <=(const AutodiffVar& a, const AutodiffVar& b) { return a.Value <= b.Value; }
+inline bool operator >=(const AutodiffVar& a, const AutodiffVar& b) { return a.Value >= b.Value; }
+
+inline AutodiffVar sin(const AutodiffVar& a) { return AutodiffVar::Unary(a, std::sin(a.Value), std::cos(a.Value)); }
+inline AutodiffVar cos(const AutodiffVar& a) { return AutodiffVar::Unary(a, std::cos(a.Value), -std::sin(a.Value)); }
+inline AutodiffVar abs(const AutodiffVar& a) { return AutodiffVar::Unary(a, std::abs(a.Value), a.Value < 0.0 ? -1.0 : 1.0); }
+
+// The derivative is taken as zero at the origin, where the magnitude terms of the penalty start.
+inline AutodiffVar sqrt(const AutodiffVar& a) {
+    FP root = std::sqrt(a.Value);
+    return AutodiffVar::Unary(a, root, root > 0.0 ? 0.5 / root : 0.0);
+}
+
+// Rounded once like `std::fma`, recorded as the product and the sum it fuses.
+inline AutodiffVar fma(const AutodiffVar& a, const AutodiffVar& b, const AutodiffVar& c) {
+    return AutodiffVar::Binary(a * b, 1.0, c, 1.0, std::fma(a.Value, b.Value, c.Value));
+}
+
+inline AutodiffVar fmod(const AutodiffVar& a, FP m) { return AutodiffVar::Unary(a, std::fmod(a.Value, m), 1.0); }
+
+inline FP ValueOf(FP x) { return x; }
+inline FP ValueOf(const AutodiffVar& x) { return x.Value; }
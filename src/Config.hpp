@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "FPType.hpp"
 #include "Vec2.hpp"
 
@@ -8,6 +10,16 @@ constexpr unsigned int Hidden1Size = 10;
 constexpr unsigned int Hidden2Size = 5;
 constexpr unsigned int OutputSize = 2;
 
+enum class ActivationKind {
+    LeakyReLU,
+    FastTanh,
+    FastSigmoid,
+    Cbrt,
+};
+
+// Nonlinearity of every neuron, fixed at compile time. Recorded in checkpoints, which only load with the same activation.
+constexpr ActivationKind NetworkActivation = ActivationKind::LeakyReLU;
+
 constexpr FP PhysicsSimDeltaT = 1.0 / 60.0;
 constexpr FP PhysicsSimTargetDroneSpeed = 1.5;
 
@@ -26,6 +38,17 @@ constexpr unsigned int SelectNBest = 50;
 constexpr unsigned int SimulationsPerDrone = 10;
 constexpr unsigned int SimulationThreads = 4;
 
+enum class ThreadPinning {
+    None,       // The OS places and migrates the training threads.
+    Compact,    // Fill one NUMA node (socket) before the next.
+    Scatter,    // Spread over NUMA nodes and cores.
+};
+
+// Pinned training threads keep their caches. Drones are evaluated by whichever thread is free, not by the one that built
+// them, so pinning does not keep a genome on the node of the thread evaluating it.
+// `scptools pin-bench` compares the policies on the machine at hand.
+constexpr ThreadPinning TrainingThreadPinning = ThreadPinning::None;
+
 constexpr FP TrainingDistancePenaltyWeight = 20.0;
 constexpr FP TrainingSpeedPenaltyWeight = 20.0;
 constexpr FP TrainingAnglePenaltyWeight = 5.0;
@@ -36,9 +59,66 @@ constexpr FP TrainingMaxCoords = 4.0;
 
 constexpr bool TrainingUseRandomInitConditions = false;
 
+enum class Integrator {
+    SemiImplicitEuler,  // Velocity first, then position with the new velocity.
+    VelocityVerlet,
+    RK2,                // Midpoint method.
+    RK4,
+};
+
+// Integrator and timestep of the training simulations, and for how many physics steps each thrust request of the network is held.
+constexpr Integrator TrainingIntegrator = Integrator::SemiImplicitEuler;
+constexpr FP TrainingDeltaT = PhysicsSimDeltaT;
+constexpr unsigned int TrainingControlInterval = 1;
+
+// A drone's episodes run in lockstep batches of up to this many lanes, longest first; a finished episode's lane is
+// refilled from the queue, so short episodes do not leave the batch half empty. `SimulationsPerDrone` runs all at once.
+// 4 matches the input block of the dense layer kernels (`KernelBatch`).
+constexpr unsigned int TrainingEpisodeLanes = 4;
+
+// Training episodes keep the heading as (cos, sin) and rotate it every step (`PhysicsSim::HeadingStep`) instead of calling sin/cos.
+// Only used with `Integrator::SemiImplicitEuler`.
+constexpr bool TrainingIncrementalHeading = true;
+
+// The fused heading step is a semi-implicit Euler step.
+constexpr bool TrainingUsesHeadingStep = TrainingIncrementalHeading && TrainingIntegrator == Integrator::SemiImplicitEuler;
+
+enum class CrossoverKind {
+    Average,    // Every gene is the mean of both parents.
+    Uniform,    // Every gene is copied from either parent.
+};
+
+constexpr CrossoverKind TrainingCrossover = CrossoverKind::Average;
+constexpr unsigned int TrainingMutatedGenes = 1;
+
+// Which networks are compiled only changes the speed of training, never its results: the JIT adds up every neuron like
+// `ConnectionStep`, so its outputs are bit-identical to `EvaluateNetwork` (checked by `scptools jit`). That keeps runs
+// reproducible under `Auto`, whose choice depends on timings measured once per process.
+enum class JitPolicy {
+    Never,
+    Auto,       // Compile a drone's network when the measured JIT cost model says it pays off.
+    Always,
+};
+
+constexpr JitPolicy TrainingJitPolicy = JitPolicy::Auto;
+
+// Every `TrainingFineTuneInterval` generations (0 disables it) the best `TrainingFineTuneElites` drones get
+// `TrainingFineTuneSteps` gradient steps on the exact penalty gradient (see `DifferentiableSim`).
+constexpr unsigned int TrainingFineTuneInterval = 0;
+constexpr unsigned int TrainingFineTuneElites = 4;
+constexpr unsigned int TrainingFineTuneSteps = 10;
+constexpr FP TrainingFineTuneLearningRate = 1e-3;
+
+// Seed of a training run. Every random draw of the run is a function of it and of what the draw is for (see
+// `CounterRng.hpp`), so runs with the same seed are bit-identical whatever `SimulationThreads` is.
+constexpr uint64_t TrainingSeed = 1;
+
 constexpr const char* CheckpointFileName = "checkpoint.gen";
 
 
 static_assert(InputSize == 7 && OutputSize == 2);
 static_assert(SelectNBest <= GenerationSize);
-static_assert(GenerationSize % SimulationThreads == 0);
\ No newline at end of file
+static_assert(GenerationSize % SimulationThreads == 0);
+static_assert(TrainingFineTuneElites <= SelectNBest);
+static_assert(TrainingControlInterval >= 1);
+static_assert(TrainingEpisodeLanes >= 1);
\ No newline at end of file
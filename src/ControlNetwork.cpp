@@ -1,179 +1,179 @@
 #include "ControlNetwork.hpp"
 #include "Config.hpp"
+#include "Kernels.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <random>
 
-static FP ReLU(FP x) {
-    if (x < 0.0) return 0.1 * x;
-    return x;
-}
-
-/*static FP Sigmoid(FP x) {
-    return 1.0 / (1.0 + std::exp(-x));
-}
-
-static FP Act3(FP x) {
-    return std::cbrt(x);
-}*/
-
-static const auto ActivationFunc = ReLU;
+// Samples per chunk of `EvaluateNetworkBatch`, sized so the hidden activations stay small enough for the stack.
+static constexpr int BatchChunkSize = std::max<int>(1, 4096 / std::max(Hidden1Size, Hidden2Size));
 
-ControlNetwork::ControlNetwork(ControlNetwork::InitMode mode) {
+template <class Activation>
+BasicControlNetwork<Activation>::BasicControlNetwork(InitMode mode) : Genome(GenomeSize) {
     switch(mode) {
-        case ControlNetwork::InitMode::Zeroes:
+        case InitMode::Zeroes:
             InitZeroes();
             break;
-        case ControlNetwork::InitMode::Random:
+        case InitMode::Random:
             InitRandom();
             break;
+        case InitMode::Uninitialized:
+            break;
     }
 }
 
-ControlNetwork::ControlNetwork(const ControlNetwork& other) {
-    InToH1Weights = other.InToH1Weights;
-    H1ToH2Weights = other.H1ToH2Weights;
-    H2ToOutWeights = other.H2ToOutWeights;
+template <class Activation>
+BasicControlNetwork<Activation>::BasicControlNetwork(const BasicControlNetwork& other) : Genome(other.Genome), Sparse(other.Sparse), Packed(other.Packed) { }
 
-    H1Biases = other.H1Biases;
-    H2Biases = other.H2Biases;
-    OutBiases = other.OutBiases;
+template <class Activation>
+BasicControlNetwork<Activation>::BasicControlNetwork(BasicControlNetwork&& other) noexcept : Genome(std::move(other.Genome)), Sparse(std::move(other.Sparse)), Packed(std::move(other.Packed)) { }
 
-    /*const FP* begin = &other.InToH1Weights[0][0];
-    const FP* afterLast = (&other.OutBiases[other.OutBiases.size() - 1]) + 1;
-    std::memcpy(&InToH1Weights[0][0], begin, sizeof(FP) * (afterLast - begin));*/
+template <class Activation>
+BasicControlNetwork<Activation>& BasicControlNetwork<Activation>::operator =(const BasicControlNetwork& other) {
+    Genome = other.Genome;
+    Sparse = other.Sparse;
+    Packed = other.Packed;
+    return *this;
 }
 
-ControlNetwork& ControlNetwork::operator =(const ControlNetwork& other) {
-    InToH1Weights = other.InToH1Weights;
-    H1ToH2Weights = other.H1ToH2Weights;
-    H2ToOutWeights = other.H2ToOutWeights;
-
-    H1Biases = other.H1Biases;
-    H2Biases = other.H2Biases;
-    OutBiases = other.OutBiases;
+template <class Activation>
+BasicControlNetwork<Activation>& BasicControlNetwork<Activation>::operator =(BasicControlNetwork&& other) noexcept {
+    Genome.swap(other.Genome);
+    Sparse.swap(other.Sparse);
+    Packed.swap(other.Packed);
     return *this;
 }
 
-void ControlNetwork::InitZeroes() {
-    InToH1Weights.fill({0});
-    H1ToH2Weights.fill({0});
-    H2ToOutWeights.fill({0});
+template <class Activation>
+void BasicControlNetwork<Activation>::InitZeroes() {
+    std::fill(Genome.begin(), Genome.end(), 0.0);
+}
 
-    H1Biases.fill(0);
-    H2Biases.fill(0);
-    OutBiases.fill(0);
+template <class Activation>
+void BasicControlNetwork<Activation>::InitRandom() {
+    std::mt19937_64 gen {std::random_device {}()};
+    Randomize(gen);
 }
 
-void ControlNetwork::InitRandom() {
-    std::random_device rd {};
-    std::mt19937 gen {rd()};
+template <class Activation>
+std::array<FP, OutputSize> BasicControlNetwork<Activation>::EvaluateNetwork(const std::array<FP, InputSize>& input) const {
+    if (Sparse) {
+        std::array<FP, OutputSize> out;
+        EvaluateSparse(input.data(), out.data(), 1);
+        return out;
+    }
 
-    std::normal_distribution<FP> dist {0.0, 1.0};
-    
-    ApplyForEachValue([&dist, &gen] (double& i) {
-        i = dist(gen);
-    });
-    
-}
+    const PackedWeights* packed = Packed.get();
 
-std::array<FP, OutputSize> ControlNetwork::EvaluateNetwork(const std::array<FP, InputSize>& input) {
     std::array<FP, Hidden1Size> h1activations;
-
-    for (int i = 0; i < (int) Hidden1Size; i++) {
-        FP sum = 0;
-        for (int j = 0; j < (int) InputSize; j++) {
-            sum += input[j] * InToH1Weights[i][j] + H1Biases[i];
-        }
-        h1activations[i] = ActivationFunc(sum);
-    }
+    DenseLayerFixed<Hidden1Size, InputSize, Activation>(packed ? &packed->InToH1 : nullptr, InToH1Weights().Data, H1Biases().data(), input.data(), InputSize, h1activations.data(), Hidden1Size, 1);
 
     std::array<FP, Hidden2Size> h2Activations;
-
-    for (int i = 0; i < (int) Hidden2Size; i++) {
-        FP sum = 0;
-        for (int j = 0; j < (int) Hidden1Size; j++) {
-            sum += h1activations[j] * H1ToH2Weights[i][j] + H2Biases[i];
-        }
-        h2Activations[i] = ActivationFunc(sum);
-    }
+    DenseLayerFixed<Hidden2Size, Hidden1Size, Activation>(packed ? &packed->H1ToH2 : nullptr, H1ToH2Weights().Data, H2Biases().data(), h1activations.data(), Hidden1Size, h2Activations.data(), Hidden2Size, 1);
 
     std::array<FP, OutputSize> outActivations;
-
-    for (int i = 0; i < (int) OutputSize; i++) {
-        FP sum = 0;
-        for (int j = 0; j < (int) Hidden2Size; j++) {
-            sum += h2Activations[j] * H2ToOutWeights[i][j] + OutBiases[i];
-        }
-        outActivations[i] = ActivationFunc(sum);
-    }
+    DenseLayerFixed<OutputSize, Hidden2Size, Activation>(packed ? &packed->H2ToOut : nullptr, H2ToOutWeights().Data, OutBiases().data(), h2Activations.data(), Hidden2Size, outActivations.data(), OutputSize, 1);
 
     return outActivations;
 }
 
-ControlNetwork ControlNetwork::GenerateChild(FP mRate, const ControlNetwork& a, const ControlNetwork& b) {
-    static thread_local std::random_device rd {};
-    static thread_local std::mt19937 gen {rd()};
+template <class Activation>
+void BasicControlNetwork<Activation>::EvaluateNetworkBatch(const FP* inputs, FP* outputs, int count) const {
+    if (Sparse) {
+        EvaluateSparse(inputs, outputs, count);
+        return;
+    }
 
-    std::normal_distribution<FP> dist {0.0, mRate};
-    //static thread_local std::bernoulli_distribution decide;
+    const PackedWeights* packed = Packed.get();
 
-    ControlNetwork out(InitMode::Zeroes);
+    FP h1activations[BatchChunkSize * Hidden1Size];
+    FP h2Activations[BatchChunkSize * Hidden2Size];
 
-    for (int i = 0; i < (int) Hidden1Size; i++) {
-        for (int j = 0; j < (int) InputSize; j++) {
-            auto value = (a.InToH1Weights[i][j] + b.InToH1Weights[i][j]) / 2;
-            //value += dist(gen);
-            out.InToH1Weights[i][j] = value;
-        }
-    }
+    for (int first = 0; first < count; first += BatchChunkSize) {
+        int n = std::min(BatchChunkSize, count - first);
+        const FP* in = inputs + first * InputSize;
+        FP* out = outputs + first * OutputSize;
 
-    for (int i = 0; i < (int) Hidden2Size; i++) {
-        for (int j = 0; j < (int) Hidden1Size; j++) {
-            auto value = (a.H1ToH2Weights[i][j] + b.H1ToH2Weights[i][j]) / 2;
-            //value += dist(gen);
-            out.H1ToH2Weights[i][j] = value;
-        }
+        DenseLayerFixed<Hidden1Size, InputSize, Activation>(packed ? &packed->InToH1 : nullptr, InToH1Weights().Data, H1Biases().data(), in, InputSize, h1activations, Hidden1Size, n);
+        DenseLayerFixed<Hidden2Size, Hidden1Size, Activation>(packed ? &packed->H1ToH2 : nullptr, H1ToH2Weights().Data, H2Biases().data(), h1activations, Hidden1Size, h2Activations, Hidden2Size, n);
+        DenseLayerFixed<OutputSize, Hidden2Size, Activation>(packed ? &packed->H2ToOut : nullptr, H2ToOutWeights().Data, OutBiases().data(), h2Activations, Hidden2Size, out, OutputSize, n);
     }
+}
 
-    for (int i = 0; i < (int) OutputSize; i++) {
-        for (int j = 0; j < (int) Hidden2Size; j++) {
-            auto value = (a.H2ToOutWeights[i][j] + b.H2ToOutWeights[i][j]) / 2;
-            //value += dist(gen);
-            out.H2ToOutWeights[i][j] = value;
-        }
+template <class Activation>
+void BasicControlNetwork<Activation>::EvaluateSparse(const FP* inputs, FP* outputs, int count) const {
+    FP h1activations[BatchChunkSize * Hidden1Size];
+    FP h2Activations[BatchChunkSize * Hidden2Size];
+
+    for (int first = 0; first < count; first += BatchChunkSize) {
+        int n = std::min(BatchChunkSize, count - first);
+        const FP* in = inputs + first * InputSize;
+        FP* out = outputs + first * OutputSize;
+
+        SparseLayer<Activation>(Sparse->InToH1, H1Biases().data(), in, InputSize, h1activations, Hidden1Size, n);
+        SparseLayer<Activation>(Sparse->H1ToH2, H2Biases().data(), h1activations, Hidden1Size, h2Activations, Hidden2Size, n);
+        SparseLayer<Activation>(Sparse->H2ToOut, OutBiases().data(), h2Activations, Hidden2Size, out, OutputSize, n);
     }
+}
+
+template <class Activation>
+FP BasicControlNetwork<Activation>::GetSparsity() const {
+    auto weights = GetGenome().template first<WeightCount>();
+    return (FP) std::count(weights.begin(), weights.end(), 0.0) / WeightCount;
+}
 
-    for (int i = 0; i < (int) Hidden1Size; i++) {
-        auto value = (a.H1Biases[i] + b.H1Biases[i]) / 2;
-        //value += dist(gen);
-        out.H1Biases[i] = value;
+template <class Activation>
+void BasicControlNetwork<Activation>::UpdateLayout(bool sparse) {
+    if constexpr (HasWideLayers) {
+        auto pack = [] (bool usesPanels, const MatrixView<const FP>& w, const FP* b) {
+            return usesPanels ? PackedMatrix::FromDense(w, b) : PackedMatrix {};
+        };
+
+        Packed = std::make_shared<const PackedWeights>(PackedWeights {
+            pack(KernelUsesPanels<Hidden1Size, InputSize>, InToH1Weights(), H1Biases().data()),
+            pack(KernelUsesPanels<Hidden2Size, Hidden1Size>, H1ToH2Weights(), H2Biases().data()),
+            pack(KernelUsesPanels<OutputSize, Hidden2Size>, H2ToOutWeights(), OutBiases().data()),
+        });
     }
 
-    for (int i = 0; i < (int) Hidden2Size; i++) {
-        auto value = (a.H2Biases[i] + b.H2Biases[i]) / 2;
-        //value += dist(gen);
-        out.H2Biases[i] = value;
+    if (!sparse) {
+        Sparse.reset();
+        return;
     }
 
-    for (int i = 0; i < (int) OutputSize; i++) {
-        auto value = (a.OutBiases[i] + b.OutBiases[i]) / 2;
-        //value += dist(gen);
-        out.OutBiases[i] = value;
+    Sparse = std::make_shared<const SparseWeights>(SparseWeights {
+        SparseMatrix::FromDense(InToH1Weights()),
+        SparseMatrix::FromDense(H1ToH2Weights()),
+        SparseMatrix::FromDense(H2ToOutWeights()),
+    });
+}
+
+template <class Activation>
+void BasicControlNetwork<Activation>::Prune(FP threshold) {
+    for (size_t i = 0; i < WeightCount; i++) {
+        if (std::abs(Genome[i]) < threshold) Genome[i] = 0.0;
     }
+    UpdateLayout();
+}
 
-    FP* begin = &out.InToH1Weights[0][0];
-    FP* afterLast = (&out.OutBiases[out.OutBiases.size() - 1]) + 1;
-    
-    int randomGene = rand() % (afterLast - begin);
+template <class Activation>
+void BasicControlNetwork<Activation>::Reproduce(const ReproductionParams& params, const BasicControlNetwork& a, const BasicControlNetwork& b) {
+    static thread_local std::mt19937_64 gen {std::random_device{}()};
 
-    begin[randomGene] += dist(gen);
+    Reproduce(params, a, b, gen);
+}
 
+template <class Activation>
+BasicControlNetwork<Activation> BasicControlNetwork<Activation>::GenerateChild(FP mRate, const BasicControlNetwork& a, const BasicControlNetwork& b) {
+    BasicControlNetwork out(InitMode::Uninitialized);
+    out.Reproduce({CrossoverKind::Average, mRate, 1}, a, b);
     return out;
 }
 
-FP ControlNetwork::GetAbsoluteNetworkWeight() {
+template <class Activation>
+FP BasicControlNetwork<Activation>::GetAbsoluteNetworkWeight() {
     FP total = 0.0;
 
     ApplyForEachValue([&total] (FP w) {
@@ -181,4 +181,9 @@ FP ControlNetwork::GetAbsoluteNetworkWeight() {
     });
     
     return total;
-}
\ No newline at end of file
+}
+
+template class BasicControlNetwork<LeakyReLUActivation>;
+template class BasicControlNetwork<FastTanhActivation>;
+template class BasicControlNetwork<FastSigmoidActivation>;
+template class BasicControlNetwork<CbrtActivation>;
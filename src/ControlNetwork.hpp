@@ -1,40 +1,147 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <memory>
+#include <span>
+#include <vector>
 
+#include "Activations.hpp"
 #include "Config.hpp"
-
-class ControlNetwork {
+#include "Kernels.hpp"
+#include "RandomBatch.hpp"
+#include "Reproduction.hpp"
+#include "Simd.hpp"
+
+// Neural network controller. `Activation` is one of the policies in `Activations.hpp`, resolved at compile time
+// so every neuron's nonlinearity inlines into the layer kernels.
+template <class Activation>
+class BasicControlNetwork {
     public:
+        using ActivationType = Activation;
+
         enum class InitMode {
             Zeroes,
             Random,
+            Uninitialized,  // Genome left unwritten, for networks that are overwritten whole (see `Reproduce`).
         };
 
+        // Layout of the flat genome, in checkpoint order. Weight matrices are row-major, one row per output neuron.
+        static constexpr size_t InToH1Offset = 0;
+        static constexpr size_t H1ToH2Offset = InToH1Offset + Hidden1Size * InputSize;
+        static constexpr size_t H2ToOutOffset = H1ToH2Offset + Hidden2Size * Hidden1Size;
+        static constexpr size_t H1BiasOffset = H2ToOutOffset + OutputSize * Hidden2Size;
+        static constexpr size_t H2BiasOffset = H1BiasOffset + Hidden1Size;
+        static constexpr size_t OutBiasOffset = H2BiasOffset + Hidden2Size;
+        static constexpr size_t GenomeSize = OutBiasOffset + OutputSize;
+
+        static constexpr size_t WeightCount = H1BiasOffset;
+
+        static_assert(std::max({InputSize, Hidden1Size, Hidden2Size}) <= UINT16_MAX, "SparseMatrix column indices are 16 bit");
+
     private:
         friend class TrainingSim;
 
-        std::array<std::array<FP, InputSize>, Hidden1Size> InToH1Weights;
-        std::array<std::array<FP, Hidden1Size>, Hidden2Size> H1ToH2Weights;
-        std::array<std::array<FP, Hidden2Size>, OutputSize> H2ToOutWeights;
+        // Nonzero weights of each layer, present while the weights are sparse enough to evaluate this way.
+        struct SparseWeights {
+            SparseMatrix InToH1;
+            SparseMatrix H1ToH2;
+            SparseMatrix H2ToOut;
+        };
+
+        // All weights and biases in one heap buffer, so wide networks don't grow `sizeof(Drone)`.
+        std::vector<FP, SimdAllocator<FP>> Genome;
+
+        std::shared_ptr<const SparseWeights> Sparse;
+
+        // Weight panels of the layers that `DenseLayerFixed` evaluates with `DenseLayer` (empty for the others). Only
+        // built for networks with such a layer.
+        struct PackedWeights {
+            PackedMatrix InToH1;
+            PackedMatrix H1ToH2;
+            PackedMatrix H2ToOut;
+        };
+
+        static constexpr bool HasWideLayers = KernelUsesPanels<Hidden1Size, InputSize> || KernelUsesPanels<Hidden2Size, Hidden1Size> || KernelUsesPanels<OutputSize, Hidden2Size>;
 
-        std::array<FP, Hidden1Size> H1Biases;
-        std::array<FP, Hidden2Size> H2Biases;
-        std::array<FP, OutputSize> OutBiases;
+        std::shared_ptr<const PackedWeights> Packed;
 
     public:
-        ControlNetwork(InitMode mode = InitMode::Random);
-        ControlNetwork(const ControlNetwork& other);
+        BasicControlNetwork(InitMode mode = InitMode::Random);
+        BasicControlNetwork(const BasicControlNetwork& other);
+        BasicControlNetwork(BasicControlNetwork&& other) noexcept;
 
-        ControlNetwork& operator =(const ControlNetwork& other);
+        BasicControlNetwork& operator =(const BasicControlNetwork& other);
+        BasicControlNetwork& operator =(BasicControlNetwork&& other) noexcept;
 
-        std::array<FP, OutputSize> EvaluateNetwork(const std::array<FP, InputSize>& input);
+        std::array<FP, OutputSize> EvaluateNetwork(const std::array<FP, InputSize>& input) const;
 
-        static ControlNetwork GenerateChild(FP mRate, const ControlNetwork& a, const ControlNetwork& b);
+        // Evaluates `count` inputs at once (`count x InputSize` in, `count x OutputSize` out), turning each layer into a small GEMM.
+        void EvaluateNetworkBatch(const FP* inputs, FP* outputs, int count) const;
+
+        // Evaluates `min(inputs.size(), outputs.size())` inputs.
+        void EvaluateNetworkBatch(std::span<const std::array<FP, InputSize>> inputs, std::span<std::array<FP, OutputSize>> outputs) const {
+            static_assert(sizeof(std::array<FP, InputSize>) == InputSize * sizeof(FP) && sizeof(std::array<FP, OutputSize>) == OutputSize * sizeof(FP));
+            int count = (int) std::min(inputs.size(), outputs.size());
+            EvaluateNetworkBatch(reinterpret_cast<const FP*>(inputs.data()), reinterpret_cast<FP*>(outputs.data()), count);
+        }
+
+        // Fraction of weights (biases excluded) that are exactly zero.
+        FP GetSparsity() const;
+
+        // Rebuilds the weight panels of wide layers, and evaluates through the sparse kernels only when `sparse` is set.
+        // Those are barely faster than the dense ones even with almost every weight pruned (see `SparseLayer`), so
+        // nothing selects them on its own; `scptools prune` asks for them to measure. Needed after modifying the genome
+        // through `GetGenome`, which drops both layouts; `Reproduce`, `Randomize` and `Prune` call it themselves.
+        void UpdateLayout(bool sparse = false);
+
+        bool UsesSparseEvaluation() const { return Sparse != nullptr; }
+
+        // Zeroes every weight with magnitude below `threshold` (biases are kept) and updates the dense layout.
+        void Prune(FP threshold);
+
+        // Overwrites this genome with a child of `a` and `b`, neither of which may be this network.
+        void Reproduce(const ReproductionParams& params, const BasicControlNetwork& a, const BasicControlNetwork& b);
+
+        // Same, drawing from `gen` (a 64-bit URBG) instead of a thread-local generator.
+        template <class G>
+        void Reproduce(const ReproductionParams& params, const BasicControlNetwork& a, const BasicControlNetwork& b, G& gen) {
+            ::Reproduce(GetGenome(), a.Genome, b.Genome, params, gen);
+            UpdateLayout();
+        }
+
+        // Overwrites the genome with N(0, 1) draws from `gen`.
+        template <class G>
+        void Randomize(G& gen) {
+            FillNormal(gen, GetGenome(), 1.0);
+            UpdateLayout();
+        }
+
+        // Mean of both parents with one mutated gene.
+        static BasicControlNetwork GenerateChild(FP mRate, const BasicControlNetwork& a, const BasicControlNetwork& b);
 
         FP GetAbsoluteNetworkWeight();
+
+        // Mutable access drops the sparse and packed layouts, call `UpdateLayout` once done.
+        std::span<FP, GenomeSize> GetGenome() {
+            Sparse.reset();
+            Packed.reset();
+            return std::span<FP, GenomeSize>(Genome.data(), GenomeSize);
+        }
+
+        std::span<const FP, GenomeSize> GetGenome() const { return std::span<const FP, GenomeSize>(Genome.data(), GenomeSize); }
+
+        MatrixView<const FP> InToH1Weights() const { return {Genome.data() + InToH1Offset, Hidden1Size, InputSize}; }
+        MatrixView<const FP> H1ToH2Weights() const { return {Genome.data() + H1ToH2Offset, Hidden2Size, Hidden1Size}; }
+        MatrixView<const FP> H2ToOutWeights() const { return {Genome.data() + H2ToOutOffset, OutputSize, Hidden2Size}; }
+
+        std::span<const FP, Hidden1Size> H1Biases() const { return GetGenome().template subspan<H1BiasOffset, Hidden1Size>(); }
+        std::span<const FP, Hidden2Size> H2Biases() const { return GetGenome().template subspan<H2BiasOffset, Hidden2Size>(); }
+        std::span<const FP, OutputSize> OutBiases() const { return GetGenome().template subspan<OutBiasOffset, OutputSize>(); }
         
     private:
+        void EvaluateSparse(const FP* inputs, FP* outputs, int count) const;
+
         void InitZeroes();
         void InitRandom();
 
@@ -42,42 +149,11 @@ class ControlNetwork {
         requires requires (F func, double& i) {
             func(i);
         }
-        void ApplyForEachValue(const F& func); 
-};
-
-template <class F>
-requires requires (F func, double& i) {
-    func(i);
-}
-void ControlNetwork::ApplyForEachValue(const F& func) {
-    for (auto& iarr : InToH1Weights) {
-        for (auto& i : iarr) {
-            func(i);
-        }
-    }
-
-    for (auto& iarr : H1ToH2Weights) {
-        for (auto& i : iarr) {
-            func(i);
-        }
-    }
-
-    for (auto& iarr : H2ToOutWeights) {
-        for (auto& i : iarr) {
-            func(i);
+        void ApplyForEachValue(const F& func) {
+            for (auto& i : Genome) {
+                func(i);
+            }
         }
-    }
-
-    for (auto& i : H1Biases) {
-        func(i);
-    }
-
-    for (auto& i : H2Biases) {
-        func(i);
-    }
+};
 
-    for (auto& i : OutBiases) {
-        func(i);
-    }
-}
-        
\ No newline at end of file
+using ControlNetwork = BasicControlNetwork<ActivationPolicy<NetworkActivation>>;
@@ -0,0 +1,217 @@
+#include "ControllerExport.hpp"
+#include "Config.hpp"
+
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static constexpr const char* ExportScalarName = std::is_same_v<FP, float> ? "float" : "double";
+
+// `constexpr` version of the network's activation policy, same formulas as `Activations.hpp`.
+static void WriteActivation(std::ostream& out) {
+    switch (NetworkActivation) {
+        case ActivationKind::LeakyReLU:
+            out << "    constexpr Scalar Activation(Scalar x) {\n";
+            out << "        return x < Scalar(0) ? Scalar(0.1) * x : x;\n";
+            out << "    }\n\n";
+            break;
+        case ActivationKind::FastTanh:
+        case ActivationKind::FastSigmoid:
+            out << "    constexpr Scalar FastTanh(Scalar x) {\n";
+            out << "        x = x < Scalar(-4.97) ? Scalar(-4.97) : x > Scalar(4.97) ? Scalar(4.97) : x;\n";
+            out << "        const Scalar x2 = x * x;\n";
+            out << "        const Scalar y = x * (Scalar(135135) + x2 * (Scalar(17325) + x2 * (Scalar(378) + x2)))\n";
+            out << "            / (Scalar(135135) + x2 * (Scalar(62370) + x2 * (Scalar(3150) + x2 * Scalar(28))));\n";
+            out << "        return y < Scalar(-1) ? Scalar(-1) : y > Scalar(1) ? Scalar(1) : y;\n";
+            out << "    }\n\n";
+            out << "    constexpr Scalar Activation(Scalar x) {\n";
+            if (NetworkActivation == ActivationKind::FastTanh) {
+                out << "        return FastTanh(x);\n";
+            } else {
+                out << "        return Scalar(0.5) + Scalar(0.5) * FastTanh(Scalar(0.5) * x);\n";
+            }
+            out << "    }\n\n";
+            break;
+        case ActivationKind::Cbrt:
+            // Newton from above converges monotonically for any positive start at or over the root.
+            out << "    constexpr Scalar Activation(Scalar x) {\n";
+            out << "        const Scalar a = x < Scalar(0) ? -x : x;\n";
+            out << "        if (a == Scalar(0)) return Scalar(0);\n";
+            out << "        Scalar y = a > Scalar(1) ? a : Scalar(1);\n";
+            out << "        for (int i = 0; i < 200; i++) {\n";
+            out << "            const Scalar next = y - (y * y * y - a) / (Scalar(3) * y * y);\n";
+            out << "            if (!(next < y)) break;\n";
+            out << "            y = next;\n";
+            out << "        }\n";
+            out << "        return x < Scalar(0) ? -y : y;\n";
+            out << "    }\n\n";
+            break;
+    }
+}
+
+static void WriteMatrix(std::ostream& out, const char* name, const MatrixView<const FP>& values) {
+    out << "    inline constexpr Scalar " << name << "[" << values.Rows << "][" << values.Cols << "] = {\n";
+    for (size_t i = 0; i < values.Rows; i++) {
+        out << "        {";
+        for (size_t j = 0; j < values.Cols; j++) {
+            out << (j == 0 ? "" : ", ") << values[i][j];
+        }
+        out << "},\n";
+    }
+    out << "    };\n\n";
+}
+
+static void WriteVector(std::ostream& out, const char* name, std::span<const FP> values) {
+    out << "    inline constexpr Scalar " << name << "[" << values.size() << "] = {";
+    for (size_t i = 0; i < values.size(); i++) {
+        out << (i == 0 ? "" : ", ") << values[i];
+    }
+    out << "};\n\n";
+}
+
+// Writes one unrolled layer. Like `EvaluateNetwork`, the bias is added once per incoming connection.
+static void WriteLayer(std::ostream& out, const char* outName, int outSize, const char* inName, int inSize, const char* weights, const char* biases) {
+    for (int i = 0; i < outSize; i++) {
+        out << "        const Scalar " << outName << i << " = Activation(Scalar(0)";
+        for (int j = 0; j < inSize; j++) {
+            out << "\n            + (" << inName << j << " * " << weights << "[" << i << "][" << j << "] + " << biases << "[" << i << "])";
+        }
+        out << ");\n";
+    }
+    out << "\n";
+}
+
+void ControllerExport::WriteHeader(const ControlNetwork& net, std::string_view name, std::ostream& out) {
+    auto oldPrecision = out.precision(std::numeric_limits<FP>::max_digits10);
+
+    out << "// Generated controller, topology " << InputSize << "-" << Hidden1Size << "-" << Hidden2Size << "-" << OutputSize << ".\n";
+    out << "// Inputs: {dx, dy, vx, vy, angular velocity, sin(angle), cos(angle)}, where (dx, dy) = position - target.\n";
+    out << "// Outputs: {left thrust, right thrust}, to be clamped to [0, 1].\n";
+    out << "#pragma once\n\n";
+    out << "#include <array>\n\n";
+    out << "namespace " << name << " {\n";
+    out << "    using Scalar = " << ExportScalarName << ";\n\n";
+
+    WriteMatrix(out, "InToH1Weights", net.InToH1Weights());
+    WriteMatrix(out, "H1ToH2Weights", net.H1ToH2Weights());
+    WriteMatrix(out, "H2ToOutWeights", net.H2ToOutWeights());
+    WriteVector(out, "H1Biases", net.H1Biases());
+    WriteVector(out, "H2Biases", net.H2Biases());
+    WriteVector(out, "OutBiases", net.OutBiases());
+
+    WriteActivation(out);
+
+    out << "    constexpr std::array<Scalar, " << OutputSize << "> Evaluate(const std::array<Scalar, " << InputSize << ">& input) {\n";
+    for (int j = 0; j < (int) InputSize; j++) {
+        out << "        const Scalar in" << j << " = input[" << j << "];\n";
+    }
+    out << "\n";
+
+    WriteLayer(out, "h1_", Hidden1Size, "in", InputSize, "InToH1Weights", "H1Biases");
+    WriteLayer(out, "h2_", Hidden2Size, "h1_", Hidden1Size, "H1ToH2Weights", "H2Biases");
+    WriteLayer(out, "out", OutputSize, "h2_", Hidden2Size, "H2ToOutWeights", "OutBiases");
+
+    out << "        return {";
+    for (int i = 0; i < (int) OutputSize; i++) {
+        out << (i == 0 ? "" : ", ") << "out" << i;
+    }
+    out << "};\n";
+    out << "    }\n";
+    out << "}\n";
+
+    out.precision(oldPrecision);
+}
+
+void ControllerExport::WriteCheck(const ControlNetwork& net, std::string_view name, std::string_view headerFile, int numSamples, uint32_t seed, std::ostream& out) {
+    std::mt19937 gen {seed};
+    std::uniform_real_distribution<FP> position {-2 * TrainingMaxCoords, 2 * TrainingMaxCoords};
+    std::uniform_real_distribution<FP> velocity {-5.0, 5.0};
+    std::uniform_real_distribution<FP> angle {-std::numbers::pi, std::numbers::pi};
+
+    std::vector<std::array<FP, InputSize>> inputs;
+    for (int n = 0; n < numSamples; n++) {
+        auto a = angle(gen);
+        std::array<FP, InputSize> input {position(gen), position(gen), velocity(gen), velocity(gen), velocity(gen), std::sin(a), std::cos(a)};
+        inputs.push_back(input);
+    }
+
+    auto oldPrecision = out.precision(std::numeric_limits<FP>::max_digits10);
+
+    out << "// Generated check: compiles only if `" << name << "::Evaluate` matches `ControlNetwork::EvaluateNetwork`.\n";
+    out << "#include \"" << headerFile << "\"\n\n";
+    out << "namespace {\n";
+    out << "    constexpr int NumSamples = " << numSamples << ";\n\n";
+
+    out << "    constexpr " << name << "::Scalar Inputs[NumSamples][" << InputSize << "] = {\n";
+    for (auto& input : inputs) {
+        out << "        {";
+        for (int j = 0; j < (int) InputSize; j++) out << (j == 0 ? "" : ", ") << input[j];
+        out << "},\n";
+    }
+    out << "    };\n\n";
+
+    out << "    constexpr " << name << "::Scalar Expected[NumSamples][" << OutputSize << "] = {\n";
+    for (auto& input : inputs) {
+        auto expected = net.EvaluateNetwork(input);
+        out << "        {";
+        for (int i = 0; i < (int) OutputSize; i++) out << (i == 0 ? "" : ", ") << expected[i];
+        out << "},\n";
+    }
+    out << "    };\n\n";
+
+    // Relative tolerance covers summation order and FMA contraction differences between the two builds.
+    out << "    constexpr bool MatchesEvaluateNetwork() {\n";
+    out << "        for (int n = 0; n < NumSamples; n++) {\n";
+    out << "            std::array<" << name << "::Scalar, " << InputSize << "> input {};\n";
+    out << "            for (int j = 0; j < " << InputSize << "; j++) input[j] = Inputs[n][j];\n\n";
+    out << "            auto output = " << name << "::Evaluate(input);\n";
+    out << "            for (int i = 0; i < " << OutputSize << "; i++) {\n";
+    out << "                auto diff = output[i] - Expected[n][i];\n";
+    out << "                auto scale = 1 + (Expected[n][i] < 0 ? -Expected[n][i] : Expected[n][i]);\n";
+    out << "                if (diff > 1e-9 * scale || diff < -1e-9 * scale) return false;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        return true;\n";
+    out << "    }\n\n";
+    out << "    static_assert(MatchesEvaluateNetwork(), \"Exported controller does not match EvaluateNetwork.\");\n";
+    out << "}\n\n";
+    out << "int main() {\n";
+    out << "    return 0;\n";
+    out << "}\n";
+
+    out.precision(oldPrecision);
+}
+
+// FNV-1a over the bits of every gene, folded to 32 bits.
+static uint32_t ExportCheckSeed(const ControlNetwork& net) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (FP gene : net.GetGenome()) hash = (hash ^ std::bit_cast<uint64_t>((double) gene)) * 0x100000001b3;
+    return (uint32_t) (hash ^ (hash >> 32));
+}
+
+bool ControllerExport::ExportToFiles(const ControlNetwork& net, std::string_view name, std::string_view directory) {
+    std::string headerFile = std::string(name) + ".hpp";
+    std::string headerPath = std::string(directory) + "/" + headerFile;
+    std::string checkPath = std::string(directory) + "/" + std::string(name) + "_check.cpp";
+
+    std::ofstream header {headerPath};
+    std::ofstream check {checkPath};
+
+    if (!header.is_open() || !check.is_open()) {
+        std::cerr << "Could not open export files in '" << directory << "'." << std::endl;
+        return false;
+    }
+
+    WriteHeader(net, name, header);
+    WriteCheck(net, name, headerFile, 64, ExportCheckSeed(net), check);
+
+    std::cout << "Exported controller to " << headerPath << " (check: " << checkPath << ")." << std::endl;
+    return true;
+}
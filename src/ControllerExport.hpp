@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#include "ControlNetwork.hpp"
+
+// Emits trained controllers as standalone C++ headers.
+// The header holds the weights as `constexpr` arrays and an `Evaluate` function unrolled for the current topology,
+// and depends only on the standard library so it can be embedded in other simulators.
+struct ControllerExport {
+    // Writes the header, with everything placed inside `namespace <name>`.
+    static void WriteHeader(const ControlNetwork& net, std::string_view name, std::ostream& out);
+
+    // Writes a translation unit that `static_assert`s the exported `Evaluate` against `EvaluateNetwork`
+    // on `numSamples` random inputs. Compiling it is the check.
+    static void WriteCheck(const ControlNetwork& net, std::string_view name, std::string_view headerFile, int numSamples, uint32_t seed, std::ostream& out);
+
+    // Writes `<name>.hpp` and `<name>_check.cpp` inside `directory`. Returns false if a file could not be written.
+    // The check inputs are seeded from the weights, so exporting the same controller always writes the same files.
+    static bool ExportToFiles(const ControlNetwork& net, std::string_view name, std::string_view directory = ".");
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include <immintrin.h>
+
+#include "FPType.hpp"
+#include "Simd.hpp"
+
+// Counter-based random numbers: every draw is a pure function of the run seed and the logical coordinates of what
+// it is drawn for, so a training run gives the same bits on any number of threads and under any scheduling.
+
+// Lanes of 64-bit words matching `FPVec`, each holding one 32-bit word of a Philox counter.
+using PhiloxLanes = uint64_t __attribute__((vector_size(SimdBytes)));
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"): a 10-round bijection of a
+// 128-bit counter under a 64-bit key.
+struct Philox4x32 {
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static constexpr uint32_t Multiplier0 = 0xD2511F53;
+    static constexpr uint32_t Multiplier1 = 0xCD9E8D57;
+    static constexpr uint32_t Weyl0 = 0x9E3779B9;
+    static constexpr uint32_t Weyl1 = 0xBB67AE85;
+
+    static constexpr Counter Block(Counter counter, Key key) {
+        for (int round = 0; round < 10; round++) {
+            uint64_t product0 = (uint64_t) Multiplier0 * counter[0];
+            uint64_t product1 = (uint64_t) Multiplier1 * counter[2];
+
+            counter = {
+                (uint32_t) (product1 >> 32) ^ counter[1] ^ key[0],
+                (uint32_t) product1,
+                (uint32_t) (product0 >> 32) ^ counter[3] ^ key[1],
+                (uint32_t) product0,
+            };
+
+            key[0] += Weyl0;
+            key[1] += Weyl1;
+        }
+        return counter;
+    }
+
+    // `Block` on `SimdWidth` counters at once, word `i` of every counter in `c[i]`.
+    static void Blocks(std::array<PhiloxLanes, 4>& c, Key key) {
+        for (int round = 0; round < 10; round++) {
+            PhiloxLanes product0 = MultiplyLow(c[0], Multiplier0);
+            PhiloxLanes product1 = MultiplyLow(c[2], Multiplier1);
+
+            c = {
+                (product1 >> 32) ^ c[1] ^ key[0],
+                product1 & 0xffffffff,
+                (product0 >> 32) ^ c[3] ^ key[1],
+                product0 & 0xffffffff,
+            };
+
+            key[0] += Weyl0;
+            key[1] += Weyl1;
+        }
+    }
+
+    // Full 64-bit products of the low 32 bits of each lane, one instruction instead of a 64-bit multiply.
+    static PhiloxLanes MultiplyLow(PhiloxLanes a, uint32_t b) {
+        PhiloxLanes multiplier = (PhiloxLanes) {} + b;
+#if defined(__AVX512F__)
+        // Full mask; the unmasked intrinsic trips -Wuninitialized in GCC 12's headers.
+        return (PhiloxLanes) _mm512_maskz_mul_epu32(0xff, (__m512i) a, (__m512i) multiplier);
+#elif defined(__AVX2__)
+        return (PhiloxLanes) _mm256_mul_epu32((__m256i) a, (__m256i) multiplier);
+#elif defined(__AVX__)
+        return a * multiplier;
+#else
+        return (PhiloxLanes) _mm_mul_epu32((__m128i) a, (__m128i) multiplier);
+#endif
+    }
+};
+
+// What a stream of draws is for, so streams with the same coordinates never overlap.
+enum class RngStream : uint32_t {
+    Initialization,     // Initial genomes.
+    Scenarios,          // Training targets, per episode.
+    InitialState,       // Random initial conditions, per episode.
+    Reproduction,       // Parent selection and genetic operators, per child.
+    FineTune,           // Scenarios of `TrainingSim::FineTuneElites`, per elite.
+};
+
+// Run seed plus the generation and drone (population index) a draw belongs to.
+struct RngKey {
+    uint64_t Seed = 0;
+    uint32_t Generation = 0;
+    uint32_t Drone = 0;
+};
+
+// 64-bit URBG over one Philox stream. The counter holds (block, generation, drone, stream << 24 | episode),
+// so a stream is good for 2^33 draws.
+class CounterRng {
+    public:
+        using result_type = uint64_t;
+
+        constexpr CounterRng(const RngKey& key, RngStream stream, uint32_t episode = 0)
+            : Key {(uint32_t) key.Seed, (uint32_t) (key.Seed >> 32)},
+              Counter {0, key.Generation, key.Drone, ((uint32_t) stream << 24) | (episode & 0xffffff)} { }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+        constexpr result_type operator()() {
+            if (Used == 2) {
+                Block = Philox4x32::Block(Counter, Key);
+                Counter[0]++;
+                Used = 0;
+            }
+
+            uint64_t value = (uint64_t) Block[2 * Used] << 32 | Block[2 * Used + 1];
+            Used++;
+            return value;
+        }
+
+        // Same values as `out.size()` calls, with `SimdWidth` blocks computed at once.
+        void Fill(std::span<uint64_t> out) {
+            size_t i = 0;
+            while (i < out.size() && Used < 2) out[i++] = (*this)();
+
+            for (; i + 2 * SimdWidth <= out.size(); i += 2 * SimdWidth) {
+                uint64_t blocks[SimdWidth];
+                for (int l = 0; l < SimdWidth; l++) blocks[l] = (uint32_t) (Counter[0] + l);
+
+                std::array<PhiloxLanes, 4> c;
+                std::memcpy(&c[0], blocks, sizeof(PhiloxLanes));
+                for (int w = 1; w < 4; w++) c[w] = (PhiloxLanes) {} + Counter[w];
+
+                Philox4x32::Blocks(c, Key);
+                Counter[0] += SimdWidth;
+
+                PhiloxLanes first = c[0] << 32 | c[1];
+                PhiloxLanes second = c[2] << 32 | c[3];
+                for (int l = 0; l < SimdWidth; l++) {
+                    out[i + 2 * l] = first[l];
+                    out[i + 2 * l + 1] = second[l];
+                }
+            }
+
+            while (i < out.size()) out[i++] = (*this)();
+        }
+
+        // Uniform in [a, b), with 53 random bits.
+        constexpr FP UniformFP(FP a, FP b) {
+            return a + ((*this)() >> 11) * 0x1p-53 * (b - a);
+        }
+
+    private:
+        Philox4x32::Key Key;
+        Philox4x32::Counter Counter;
+        Philox4x32::Counter Block {};
+        int Used = 2;
+};
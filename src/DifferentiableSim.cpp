@@ -0,0 +1,302 @@
+#include "DifferentiableSim.hpp"
+#include "Autodiff.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+static constexpr FP FineTuneBeta1 = 0.9;
+static constexpr FP FineTuneBeta2 = 0.999;
+static constexpr FP FineTuneEpsilon = 1e-8;
+
+// Only the semi-implicit Euler step (and its fused `HeadingStep` form) of training episodes is mirrored below.
+static_assert(TrainingIntegrator == Integrator::SemiImplicitEuler, "DifferentiableSim mirrors semi-implicit Euler training episodes only");
+
+namespace {
+    template <class T>
+    struct DiffDroneState {
+        T PositionX = 0.0, PositionY = 0.0;
+        T VelocityX = 0.0, VelocityY = 0.0;
+        T DirectionAngle = 0.0, AngularVelocity = 0.0;
+        std::array<T, 2> Thrust = {0.0, 0.0};
+
+        // `HeadingDroneState`, used with `TrainingUsesHeadingStep`.
+        T HeadingCos = 1.0, HeadingSin = 0.0;
+        int StepsSinceRenormalize = 0;
+
+        DiffDroneState(const DroneState& start)
+            : PositionX(start.Position.x), PositionY(start.Position.y), VelocityX(start.Velocity.x), VelocityY(start.Velocity.y),
+              DirectionAngle(start.DirectionAngle), AngularVelocity(start.AngularVelocity) {
+            HeadingDroneState heading {start};
+            HeadingCos = heading.HeadingCos;
+            HeadingSin = heading.HeadingSin;
+        }
+    };
+}
+
+using std::abs, std::cos, std::fmod, std::sin, std::sqrt;
+
+template <class T>
+static T DiffActivation(const T& x) {
+    using Activation = ControlNetwork::ActivationType;
+
+    if constexpr (std::is_same_v<T, AutodiffVar>) {
+        return AutodiffVar::Unary(x, Activation::Apply(x.Value), Activation::Derivative(x.Value));
+    } else {
+        return Activation::Apply(x);
+    }
+}
+
+// Adds up each neuron in the order of `ConnectionStep`, so the values match the network's own layers exactly.
+template <class T>
+static void DiffLayer(const T* w, const T* b, int rows, int cols, const T* x, T* y) {
+    using std::fma;
+    for (int i = 0; i < rows; i++) {
+        T sum = 0.0;
+        for (int j = 0; j < cols; j++) sum = sum + fma(x[j], w[i * cols + j], b[i]);
+        y[i] = DiffActivation(sum);
+    }
+}
+
+template <class T>
+static std::array<T, OutputSize> DiffEvaluateNetwork(const std::vector<T>& genome, const std::array<T, InputSize>& input) {
+    std::array<T, Hidden1Size> h1;
+    std::array<T, Hidden2Size> h2;
+    std::array<T, OutputSize> out;
+
+    DiffLayer(genome.data() + ControlNetwork::InToH1Offset, genome.data() + ControlNetwork::H1BiasOffset, Hidden1Size, InputSize, input.data(), h1.data());
+    DiffLayer(genome.data() + ControlNetwork::H1ToH2Offset, genome.data() + ControlNetwork::H2BiasOffset, Hidden2Size, Hidden1Size, h1.data(), h2.data());
+    DiffLayer(genome.data() + ControlNetwork::H2ToOutOffset, genome.data() + ControlNetwork::OutBiasOffset, OutputSize, Hidden2Size, h2.data(), out.data());
+
+    return out;
+}
+
+template <class T>
+static void DiffUpdateThrust(T& thrust, T request, FP deltaT) {
+    if (request < 0.0) request = 0.0;
+    if (request > 1.0) request = 1.0;
+
+    FP thrustChange = DroneThrustChangeSpeed * deltaT;
+
+    if (request > thrust + thrustChange) {
+        thrust = thrust + thrustChange;
+    }
+    else if (request < thrust - thrustChange) {
+        thrust = thrust - thrustChange;
+    }
+    else {
+        thrust = request;
+    }
+}
+
+template <class T>
+static void DiffIntegrateState(DiffDroneState<T>& s, FP deltaT) {
+    T thrustSum = s.Thrust[0] + s.Thrust[1];
+
+    // `Gravity + Vec2(0, thrustSum).Rotated(angle) * DroneThrust`, in the same order as `PhysicsSim`.
+    T c = cos(s.DirectionAngle);
+    T n = sin(s.DirectionAngle);
+    T forceX = (0.0 + Gravity.x) + (0.0 * c - thrustSum * n) * DroneThrust;
+    T forceY = (0.0 + Gravity.y) + (0.0 * n + thrustSum * c) * DroneThrust;
+
+    s.VelocityX += forceX / DroneMass * deltaT;
+    s.VelocityY += forceY / DroneMass * deltaT;
+    s.PositionX += s.VelocityX * deltaT;
+    s.PositionY += s.VelocityY * deltaT;
+
+    T torqueImbalance = (s.Thrust[1] - s.Thrust[0]) * DroneTorqueMultiplier;
+    T angularAcceleration = torqueImbalance / DroneMomentOfInertia;
+
+    s.AngularVelocity += angularAcceleration * deltaT;
+    s.DirectionAngle += s.AngularVelocity * deltaT;
+    s.DirectionAngle = fmod(s.DirectionAngle, 2.0 * std::numbers::pi);
+}
+
+template <class T>
+static void DiffHeadingStep(DiffDroneState<T>& s, const T& left, const T& right, FP deltaT) {
+    DiffUpdateThrust(s.Thrust[0], left, deltaT);
+    DiffUpdateThrust(s.Thrust[1], right, deltaT);
+
+    T thrustForce = (s.Thrust[0] + s.Thrust[1]) * DroneThrust;
+    T forceX = Gravity.x + -thrustForce * s.HeadingSin;
+    T forceY = Gravity.y + thrustForce * s.HeadingCos;
+
+    s.VelocityX += forceX / DroneMass * deltaT;
+    s.VelocityY += forceY / DroneMass * deltaT;
+    s.PositionX += s.VelocityX * deltaT;
+    s.PositionY += s.VelocityY * deltaT;
+
+    T torqueImbalance = (s.Thrust[1] - s.Thrust[0]) * DroneTorqueMultiplier;
+    T angularAcceleration = torqueImbalance / DroneMomentOfInertia;
+
+    s.AngularVelocity += angularAcceleration * deltaT;
+
+    T delta = s.AngularVelocity * deltaT;
+    s.DirectionAngle += delta;
+    if (abs(s.DirectionAngle) >= 2.0 * std::numbers::pi) {
+        s.DirectionAngle = fmod(s.DirectionAngle, 2.0 * std::numbers::pi);
+    }
+
+    T deltaCos, deltaSin;
+    if (abs(delta) <= PhysicsSim::HeadingSeriesLimit) {
+        T d2 = delta * delta;
+        deltaCos = 1.0 - d2 * (1.0 / 2) * (1.0 - d2 * (1.0 / 12) * (1.0 - d2 * (1.0 / 30) * (1.0 - d2 * (1.0 / 56) * (1.0 - d2 * (1.0 / 90)))));
+        deltaSin = delta * (1.0 - d2 * (1.0 / 6) * (1.0 - d2 * (1.0 / 20) * (1.0 - d2 * (1.0 / 42) * (1.0 - d2 * (1.0 / 72) * (1.0 - d2 * (1.0 / 110))))));
+    }
+    else {
+        deltaCos = cos(delta);
+        deltaSin = sin(delta);
+    }
+
+    T c = s.HeadingCos * deltaCos - s.HeadingSin * deltaSin;
+    T n = s.HeadingSin * deltaCos + s.HeadingCos * deltaSin;
+
+    if (++s.StepsSinceRenormalize == PhysicsSim::HeadingRenormalizeInterval) {
+        T invLength = 1.0 / sqrt(c * c + n * n);
+        c = c * invLength;
+        n = n * invLength;
+        s.StepsSinceRenormalize = 0;
+    }
+
+    s.HeadingCos = c;
+    s.HeadingSin = n;
+}
+
+template <class T>
+static T DiffScenarioPenalty(const DiffDroneState<T>& s, const Vec2& target) {
+    T dx = s.PositionX - target.x;
+    T dy = s.PositionY - target.y;
+
+    T penalty = (dx * dx + dy * dy) * TrainingDistancePenaltyWeight;
+    penalty += sqrt(s.VelocityX * s.VelocityX + s.VelocityY * s.VelocityY) * TrainingSpeedPenaltyWeight;
+
+    T wrapped = 2 * std::numbers::pi - s.DirectionAngle;
+    penalty += abs((s.DirectionAngle < wrapped ? s.DirectionAngle : wrapped) * TrainingAnglePenaltyWeight);
+    penalty += abs(s.AngularVelocity) * TrainingAngularVelPenaltyWeight;
+    return penalty;
+}
+
+// One episode of `RunTrainingEpisodes`: the same step count, a network evaluation every `TrainingControlInterval`
+// physics steps of `TrainingDeltaT`, and the same step function.
+template <class T>
+static T DiffFlyScenario(const std::vector<T>& genome, const Scenario& scenario, const DroneState& start) {
+    DiffDroneState<T> s {start};
+
+    int stepsLeft = 0;
+    for (FP t = 0.0; t < scenario.TimeLimit; t += TrainingDeltaT) stepsLeft++;
+
+    while (stepsLeft > 0) {
+        T angleSin, angleCos;
+        if constexpr (TrainingUsesHeadingStep) {
+            angleSin = s.HeadingSin;
+            angleCos = s.HeadingCos;
+        }
+        else {
+            angleSin = sin(s.DirectionAngle);
+            angleCos = cos(s.DirectionAngle);
+        }
+        std::array<T, InputSize> input = {s.PositionX - scenario.Target.x, s.PositionY - scenario.Target.y, s.VelocityX, s.VelocityY, s.AngularVelocity, angleSin, angleCos};
+
+        auto out = DiffEvaluateNetwork(genome, input);
+
+        int steps = std::min<int>(TrainingControlInterval, stepsLeft);
+        for (int i = 0; i < steps; i++) {
+            if constexpr (TrainingUsesHeadingStep) {
+                DiffHeadingStep(s, out[0], out[1], TrainingDeltaT);
+            }
+            else {
+                DiffUpdateThrust(s.Thrust[0], out[0], TrainingDeltaT);
+                DiffUpdateThrust(s.Thrust[1], out[1], TrainingDeltaT);
+                DiffIntegrateState(s, TrainingDeltaT);
+            }
+        }
+        stepsLeft -= steps;
+    }
+
+    return DiffScenarioPenalty(s, scenario.Target);
+}
+
+FP DifferentiableSim::MeanPenalty(std::span<const FP> genome, const std::vector<Scenario>& scenarios, const RngKey& key) {
+    std::vector<FP> values(genome.begin(), genome.end());
+
+    FP penalty = 0.0;
+    for (int e = 0; e < (int) scenarios.size(); e++) penalty += DiffFlyScenario(values, scenarios[e], TrainingInitialState(key, e)) / scenarios.size();
+    return penalty;
+}
+
+FP DifferentiableSim::MeanPenaltyGradient(std::span<const FP> genome, const std::vector<Scenario>& scenarios, const RngKey& key, std::span<FP> gradient) {
+    thread_local AutodiffTape tape;
+    thread_local std::vector<FP> adjoints;
+
+    AutodiffTape::Active() = &tape;
+    std::fill(gradient.begin(), gradient.end(), 0.0);
+
+    FP penalty = 0.0;
+
+    // One tape per episode keeps it small enough to stay in cache during the reverse sweep.
+    for (int e = 0; e < (int) scenarios.size(); e++) {
+        tape.Clear();
+
+        std::vector<AutodiffVar> vars(genome.size());
+        for (size_t i = 0; i < genome.size(); i++) vars[i] = AutodiffVar::Independent(genome[i]);
+
+        AutodiffVar result = DiffFlyScenario(vars, scenarios[e], TrainingInitialState(key, e)) / (FP) scenarios.size();
+        penalty += result.Value;
+
+        if (result.Index < 0) continue;
+        tape.Backward(result.Index, adjoints);
+
+        for (size_t i = 0; i < genome.size(); i++) gradient[i] += adjoints[vars[i].Index];
+    }
+
+    AutodiffTape::Active() = nullptr;
+    return penalty;
+}
+
+FP DifferentiableSim::FineTune(ControlNetwork& net, const std::vector<Scenario>& scenarios, const RngKey& key, int steps, FP learningRate) {
+    auto genome = net.GetGenome();
+    size_t size = genome.size();
+
+    // Every step starts from the best genome with its cached gradient and Adam moments, so a rejected step costs
+    // one tape pass and leaves no trace of the trajectory it tried.
+    std::vector<FP> best(genome.begin(), genome.end()), bestGradient(size);
+    std::vector<FP> firstMoment(size, 0.0), secondMoment(size, 0.0);
+    std::vector<FP> candidate(size), gradient(size), nextFirstMoment(size), nextSecondMoment(size);
+    int adamSteps = 0;
+
+    auto isFinite = [] (FP penalty, const std::vector<FP>& g) {
+        return std::isfinite(penalty) && std::all_of(g.begin(), g.end(), [] (FP x) { return std::isfinite(x); });
+    };
+
+    FP bestPenalty = MeanPenaltyGradient(best, scenarios, key, bestGradient);
+    if (!isFinite(bestPenalty, bestGradient)) return bestPenalty;
+
+    for (int step = 0; step < steps; step++) {
+        FP correction1 = 1.0 - std::pow(FineTuneBeta1, adamSteps + 1);
+        FP correction2 = 1.0 - std::pow(FineTuneBeta2, adamSteps + 1);
+
+        for (size_t i = 0; i < size; i++) {
+            nextFirstMoment[i] = FineTuneBeta1 * firstMoment[i] + (1.0 - FineTuneBeta1) * bestGradient[i];
+            nextSecondMoment[i] = FineTuneBeta2 * secondMoment[i] + (1.0 - FineTuneBeta2) * bestGradient[i] * bestGradient[i];
+            candidate[i] = best[i] - learningRate * (nextFirstMoment[i] / correction1) / (std::sqrt(nextSecondMoment[i] / correction2) + FineTuneEpsilon);
+        }
+
+        FP penalty = MeanPenaltyGradient(candidate, scenarios, key, gradient);
+        if (!isFinite(penalty, gradient) || penalty > bestPenalty) {
+            learningRate *= 0.5;
+            continue;
+        }
+
+        bestPenalty = penalty;
+        std::swap(best, candidate);
+        std::swap(bestGradient, gradient);
+        std::swap(firstMoment, nextFirstMoment);
+        std::swap(secondMoment, nextSecondMoment);
+        adamSteps++;
+    }
+
+    std::copy(best.begin(), best.end(), genome.begin());
+    net.UpdateLayout();
+    return bestPenalty;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Config.hpp"
+#include "ControlNetwork.hpp"
+#include "Scenario.hpp"
+
+// Training episodes written over a generic scalar, so the same code runs on `FP` (to check it against
+// `TrainingSim::EpisodePenalty`) and on `AutodiffVar` (to differentiate the penalty with respect to the genome).
+// Mirrors the episodes of `TrainingSim` operation by operation: `TrainingInitialState`, `TrainingDeltaT`,
+// `TrainingControlInterval`, `PhysicsSim::HeadingStep` or `UpdateThrust` and `IntegrateState`, `ScenarioPenalty` and
+// `EvaluateNetwork`. Thrust clamping and rate limiting are piecewise, so their gradient is the one of the active piece.
+namespace DifferentiableSim {
+    // Mean penalty of `genome` over `scenarios`, flown like `TrainingSim` flies the episodes of the drone keyed by `key`
+    // (scenario `e` starts in `TrainingInitialState(key, e)`).
+    FP MeanPenalty(std::span<const FP> genome, const std::vector<Scenario>& scenarios, const RngKey& key);
+
+    // Same as `MeanPenalty`, and fills `gradient` (`GenomeSize` values) with its derivative with respect to each gene.
+    FP MeanPenaltyGradient(std::span<const FP> genome, const std::vector<Scenario>& scenarios, const RngKey& key, std::span<FP> gradient);
+
+    // `steps` Adam steps on the mean penalty over `scenarios`, each costing one gradient. A step that makes the penalty
+    // worse (or produces a non-finite gradient) is discarded with its moment updates and retried from the best network
+    // at half the learning rate, so the returned network is the best one visited. Returns its penalty.
+    FP FineTune(ControlNetwork& net, const std::vector<Scenario>& scenarios, const RngKey& key, int steps, FP learningRate);
+}
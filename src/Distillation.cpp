@@ -0,0 +1,171 @@
+#include "Distillation.hpp"
+#include "TrainingSim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+static constexpr FP AdamBeta1 = 0.9;
+static constexpr FP AdamBeta2 = 0.999;
+static constexpr FP AdamEpsilon = 1e-8;
+
+StudentNetwork::StudentNetwork(int hidden1, int hidden2, uint32_t seed) : H1(hidden1), H2(hidden2) {
+    W2Offset = H1 * InputSize;
+    W3Offset = W2Offset + H2 * H1;
+    B1Offset = W3Offset + OutputSize * H2;
+    B2Offset = B1Offset + H1;
+    B3Offset = B2Offset + H2;
+
+    size_t size = B3Offset + OutputSize;
+    Genome.assign(size, 0.0);
+    Gradient.assign(size, 0.0);
+    FirstMoment.assign(size, 0.0);
+    SecondMoment.assign(size, 0.0);
+
+    std::mt19937 gen {seed};
+    auto initLayer = [&] (size_t offset, int rows, int cols) {
+        std::normal_distribution<FP> dist {0.0, 1.0 / std::sqrt((FP) cols)};
+        for (int i = 0; i < rows * cols; i++) Genome[offset + i] = dist(gen);
+    };
+
+    initLayer(0, H1, InputSize);
+    initLayer(W2Offset, H2, H1);
+    initLayer(W3Offset, OutputSize, H2);
+    PackLayers();
+}
+
+void StudentNetwork::PackLayers() {
+    Packed[0] = PackedMatrix::FromDense({Genome.data(), (size_t) H1, InputSize}, Genome.data() + B1Offset);
+    Packed[1] = PackedMatrix::FromDense({Genome.data() + W2Offset, (size_t) H2, (size_t) H1}, Genome.data() + B2Offset);
+}
+
+std::array<FP, OutputSize> StudentNetwork::EvaluateNetwork(const std::array<FP, InputSize>& input) const {
+    std::vector<FP> h1(H1), h2(H2);
+    std::array<FP, OutputSize> out;
+
+    DenseLayer<Activation>(Packed[0], input.data(), InputSize, h1.data(), H1, 1);
+    DenseLayer<Activation>(Packed[1], h1.data(), H1, h2.data(), H2, 1);
+    DenseLayerRows<Activation>(Genome.data() + W3Offset, Genome.data() + B3Offset, OutputSize, H2, h2.data(), H2, out.data(), OutputSize, 1);
+
+    return out;
+}
+
+// Forward pass keeping pre-activations, then backpropagation of the squared error into `Gradient`.
+// Bias gradients carry the fan-in factor of the network's bias convention.
+FP StudentNetwork::AccumulateGradient(const Sample& sample) {
+    const FP* w1 = Genome.data();
+    const FP* w2 = Genome.data() + W2Offset;
+    const FP* w3 = Genome.data() + W3Offset;
+    const FP* b1 = Genome.data() + B1Offset;
+    const FP* b2 = Genome.data() + B2Offset;
+    const FP* b3 = Genome.data() + B3Offset;
+
+    const auto& x = sample.State;
+
+    thread_local std::vector<FP> z1, a1, z2, a2, d1, d2;
+    z1.resize(H1); a1.resize(H1); d1.resize(H1);
+    z2.resize(H2); a2.resize(H2); d2.resize(H2);
+
+    for (int i = 0; i < H1; i++) {
+        FP sum = 0.0;
+        for (int j = 0; j < (int) InputSize; j++) sum = ConnectionStep(sum, x[j], w1[i * InputSize + j], b1[i]);
+        z1[i] = sum;
+        a1[i] = Activation::Apply(sum);
+    }
+
+    for (int i = 0; i < H2; i++) {
+        FP sum = 0.0;
+        for (int j = 0; j < H1; j++) sum = ConnectionStep(sum, a1[j], w2[i * H1 + j], b2[i]);
+        z2[i] = sum;
+        a2[i] = Activation::Apply(sum);
+    }
+
+    FP loss = 0.0;
+    std::array<FP, OutputSize> d3;
+
+    for (int i = 0; i < (int) OutputSize; i++) {
+        FP sum = 0.0;
+        for (int j = 0; j < H2; j++) sum = ConnectionStep(sum, a2[j], w3[i * H2 + j], b3[i]);
+
+        // Motors clamp requests to [0, 1] (`PhysicsSim::UpdateThrust`), so matching the teacher past a limit it already saturates is free.
+        FP target = std::clamp(sample.Thrust[i], 0.0, 1.0);
+        FP y = Activation::Apply(sum);
+        FP error = y - target;
+        if ((target >= 1.0 && y > 1.0) || (target <= 0.0 && y < 0.0)) error = 0.0;
+
+        loss += error * error / OutputSize;
+        d3[i] = 2.0 * error / OutputSize * Activation::Derivative(sum);
+    }
+
+    FP* g1 = Gradient.data();
+    FP* g2 = Gradient.data() + W2Offset;
+    FP* g3 = Gradient.data() + W3Offset;
+
+    std::fill(d2.begin(), d2.end(), 0.0);
+    for (int i = 0; i < (int) OutputSize; i++) {
+        for (int j = 0; j < H2; j++) {
+            g3[i * H2 + j] += d3[i] * a2[j];
+            d2[j] += d3[i] * w3[i * H2 + j];
+        }
+        Gradient[B3Offset + i] += H2 * d3[i];
+    }
+
+    std::fill(d1.begin(), d1.end(), 0.0);
+    for (int i = 0; i < H2; i++) {
+        FP d = d2[i] * Activation::Derivative(z2[i]);
+        for (int j = 0; j < H1; j++) {
+            g2[i * H1 + j] += d * a1[j];
+            d1[j] += d * w2[i * H1 + j];
+        }
+        Gradient[B2Offset + i] += H1 * d;
+    }
+
+    for (int i = 0; i < H1; i++) {
+        FP d = d1[i] * Activation::Derivative(z1[i]);
+        for (int j = 0; j < (int) InputSize; j++) g1[i * InputSize + j] += d * x[j];
+        Gradient[B1Offset + i] += InputSize * d;
+    }
+
+    return loss;
+}
+
+FP StudentNetwork::TrainStep(std::span<const Sample> batch, FP learningRate) {
+    std::fill(Gradient.begin(), Gradient.end(), 0.0);
+
+    FP loss = 0.0;
+    for (auto& sample : batch) loss += AccumulateGradient(sample);
+
+    Steps++;
+    FP scale = 1.0 / batch.size();
+    FP correction1 = 1.0 - std::pow(AdamBeta1, Steps);
+    FP correction2 = 1.0 - std::pow(AdamBeta2, Steps);
+
+    for (size_t i = 0; i < Genome.size(); i++) {
+        FP g = Gradient[i] * scale;
+        FirstMoment[i] = AdamBeta1 * FirstMoment[i] + (1.0 - AdamBeta1) * g;
+        SecondMoment[i] = AdamBeta2 * SecondMoment[i] + (1.0 - AdamBeta2) * g * g;
+
+        FP m = FirstMoment[i] / correction1;
+        FP v = SecondMoment[i] / correction2;
+        Genome[i] -= learningRate * m / (std::sqrt(v) + AdamEpsilon);
+    }
+    PackLayers();
+
+    return loss * scale;
+}
+
+bool StudentNetwork::SaveCheckpoint(const char* fileName, int generations) const {
+    std::ofstream file {fileName};
+    if (!file.is_open()) return false;
+
+    TrainingSim::WriteCheckpointHeader(file, generations, H1, H2);
+
+    // Full precision so the loaded controller is exactly the verified one.
+    file.precision(17);
+    for (int drone = 0; drone < (int) GenerationSize; drone++) {
+        for (auto& i : Genome) file << i << "\n";
+    }
+
+    return file.good();
+}
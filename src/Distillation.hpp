@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Config.hpp"
+#include "ControlNetwork.hpp"
+#include "Scenario.hpp"
+
+// Network with runtime hidden sizes but the same genome layout, bias convention (added once per connection)
+// and activation as `ControlNetwork`, so a trained student can be saved as a regular checkpoint.
+class StudentNetwork {
+    public:
+        using Activation = ControlNetwork::ActivationType;
+
+        struct Sample {
+            std::array<FP, InputSize> State;
+            std::array<FP, OutputSize> Thrust;
+        };
+
+        // Random weights scaled by 1 / sqrt(fan-in), zero biases.
+        StudentNetwork(int hidden1, int hidden2, uint32_t seed);
+
+        int Hidden1() const { return H1; }
+        int Hidden2() const { return H2; }
+
+        std::span<const FP> GetGenome() const { return Genome; }
+
+        std::array<FP, OutputSize> EvaluateNetwork(const std::array<FP, InputSize>& input) const;
+
+        // One Adam step on the mean squared error of the thrust the motors receive over `batch`. Returns the loss before the step.
+        FP TrainStep(std::span<const Sample> batch, FP learningRate);
+
+        // Writes a checkpoint with `GenerationSize` copies of the student, loadable when `Config.hpp` has its hidden sizes.
+        bool SaveCheckpoint(const char* fileName, int generations) const;
+
+    private:
+        int H1, H2;
+        size_t W2Offset, W3Offset, B1Offset, B2Offset, B3Offset;
+
+        std::vector<FP> Genome;
+        std::vector<FP> Gradient;
+
+        // Panels of the hidden layers for `DenseLayer`, rebuilt after every change to the genome. The output layer has
+        // fewer neurons than a panel and goes through `DenseLayerRows`.
+        std::array<PackedMatrix, 2> Packed;
+
+        // Adam moment estimates and step count.
+        std::vector<FP> FirstMoment, SecondMoment;
+        int Steps = 0;
+
+        FP AccumulateGradient(const Sample& sample);
+        void PackLayers();
+};
+
+// Flies `pilot` through `scenarios` and labels every visited state with the teacher's thrust.
+// With the teacher as pilot this is plain behavior cloning; flying the student and labeling with the teacher
+// (DAgger) adds the states the student drifts into.
+template <class C>
+void CollectDistillationSamples(const ControlNetwork& teacher, const C& pilot, const std::vector<Scenario>& scenarios, std::vector<StudentNetwork::Sample>& out) {
+    std::vector<std::array<FP, InputSize>> states;
+
+    // Only the state is used, the pilot supplies the thrust.
+    Drone drone {ControlNetwork(ControlNetwork::InitMode::Zeroes)};
+    for (auto& scenario : scenarios) FlyScenario(drone, scenario, pilot, false, &states);
+
+    size_t first = out.size();
+    out.resize(first + states.size());
+
+    std::vector<std::array<FP, OutputSize>> thrust(states.size());
+    teacher.EvaluateNetworkBatch(states, thrust);
+
+    for (size_t i = 0; i < states.size(); i++) out[first + i] = {states[i], thrust[i]};
+}
@@ -1,25 +1,56 @@
 #pragma once
 
 #include "ControlNetwork.hpp"
+#include "NetworkJit.hpp"
 #include "Vec2.hpp"
 
+#include <memory>
 
-struct Drone {
-    ControlNetwork Brain;
+
+// Physical state of a drone, separate from its brain so many simulations can share one network.
+struct DroneState {
     Vec2 Position = {0};
     Vec2 Velocity = {0};
     FP DirectionAngle = 0;
     FP AngularVelocity = 0;
+};
+
+// `DroneState` that also carries its heading as the unit vector (cos, sin) of `DirectionAngle`, rotated
+// incrementally every step instead of recomputed, for `PhysicsSim::HeadingStep`.
+struct HeadingDroneState : DroneState {
+    FP HeadingCos = 1;
+    FP HeadingSin = 0;
+    int StepsSinceRenormalize = 0;
+
+    HeadingDroneState() = default;
+    HeadingDroneState(const DroneState& state);
+};
+
+struct Drone : DroneState {
+    ControlNetwork Brain;
 
     mutable FP TrainingScore = 1e10;
 
+    // JIT-compiled copy of `Brain`, kept while the drone survives between generations.
+    // Must be reset whenever `Brain` is modified in place.
+    std::shared_ptr<const NetworkJit> CompiledBrain;
+
     Drone() = default;
     Drone(const ControlNetwork& init) : Brain(init) { }
-    Drone(const Drone& other) : Brain(other.Brain), TrainingScore(other.TrainingScore) { }
+    Drone(const Drone& other) : Brain(other.Brain), TrainingScore(other.TrainingScore), CompiledBrain(other.CompiledBrain) { }
+    Drone(Drone&& other) noexcept : Brain(std::move(other.Brain)), TrainingScore(other.TrainingScore), CompiledBrain(std::move(other.CompiledBrain)) { }
     
     Drone& operator = (const Drone& other) {
         Brain = other.Brain;
         TrainingScore = other.TrainingScore;
+        CompiledBrain = other.CompiledBrain;
+        return *this;
+    }
+
+    Drone& operator = (Drone&& other) noexcept {
+        Brain = std::move(other.Brain);
+        TrainingScore = other.TrainingScore;
+        CompiledBrain = std::move(other.CompiledBrain);
         return *this;
     }
 };
\ No newline at end of file
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Activations.hpp"
+#include "Simd.hpp"
+#include "VectorMath.hpp"
+
+// Row-major matrix view, `m[i][j]` is row `i`, column `j`.
+template <class T>
+struct MatrixView {
+    T* Data;
+    size_t Rows;
+    size_t Cols;
+
+    T* operator [](size_t row) const {
+        return Data + row * Cols;
+    }
+};
+
+// One incoming connection of a neuron: sum + (x * w + b), with the product and the bias rounded once.
+// Every evaluation path (the layers below, `NetworkJit` and the tape of `DifferentiableSim`) adds a neuron's connections
+// in this order, one after the other starting from zero, so they all produce the same bits. It is what the original
+// `sum += x * w + b` loop of `EvaluateNetwork` compiled to with FMA contraction, so older checkpoints evaluate unchanged.
+inline FP ConnectionStep(FP sum, FP x, FP w, FP b) {
+    return sum + std::fma(x, w, b);
+}
+
+// Inputs evaluated together against the weight panels of `DenseLayer`, each an independent accumulator chain.
+constexpr int KernelBatch = 4;
+
+// Columns per pass over a batch of more than `KernelBatch` inputs, so the slice of the panels being swept stays in L1.
+constexpr int KernelDepth = 256;
+
+// Layers narrower than this, or with fewer neurons than one panel, are evaluated with plain fixed-size loops: there the
+// panel bookkeeping costs more than the arithmetic it vectorizes.
+constexpr int KernelMinBlockedCols = 32;
+
+template <int Rows, int Cols>
+constexpr bool KernelUsesPanels = Cols >= KernelMinBlockedCols && Rows >= SimdWidth;
+
+// Weights and biases of a layer rearranged for `DenseLayer`: rows in panels of `SimdWidth` neurons, each panel stored
+// column by column with one vector of weights per column. The last panel is padded with zero rows, never stored.
+// Built once per genome, like `SparseMatrix`.
+struct PackedMatrix {
+    int Rows = 0;
+    int Cols = 0;
+    std::vector<FP, SimdAllocator<FP>> Panels;
+    std::vector<FP, SimdAllocator<FP>> Biases;
+
+    int NumPanels() const {
+        return (Rows + SimdWidth - 1) / SimdWidth;
+    }
+
+    const FP* Panel(int p) const {
+        return Panels.data() + (size_t) p * Cols * SimdWidth;
+    }
+
+    static PackedMatrix FromDense(const MatrixView<const FP>& w, const FP* b) {
+        PackedMatrix out;
+        out.Rows = (int) w.Rows;
+        out.Cols = (int) w.Cols;
+        out.Panels.assign((size_t) out.NumPanels() * out.Cols * SimdWidth, 0.0);
+        out.Biases.assign((size_t) out.NumPanels() * SimdWidth, 0.0);
+
+        for (int i = 0; i < out.Rows; i++) {
+            FP* panel = out.Panels.data() + (size_t) (i / SimdWidth) * out.Cols * SimdWidth + i % SimdWidth;
+            for (int k = 0; k < out.Cols; k++) panel[k * SimdWidth] = w[i][k];
+            out.Biases[i] = b[i];
+        }
+        return out;
+    }
+};
+
+// Adds columns [k0, k1) of `MP` consecutive panels into `acc`, for `NR` inputs `ldx` apart.
+template <int MP, int NR>
+inline void DensePanelKernel(const PackedMatrix& w, int p0, int k0, int k1, const FP* x, size_t ldx, FPVec (&acc)[MP][NR]) {
+    const FP* panels[MP];
+    FPVec bias[MP];
+    for (int p = 0; p < MP; p++) {
+        panels[p] = w.Panel(p0 + p);
+        bias[p] = SimdLoad(w.Biases.data() + (p0 + p) * SimdWidth);
+    }
+
+    for (int k = k0; k < k1; k++) {
+        FPVec xv[NR];
+        for (int c = 0; c < NR; c++) xv[c] = SimdBroadcast(x[c * ldx + k]);
+
+        for (int p = 0; p < MP; p++) {
+            FPVec wv = SimdLoad(panels[p] + k * SimdWidth);
+            for (int c = 0; c < NR; c++) acc[p][c] += VectorFma(xv[c], wv, bias[p]);
+        }
+    }
+}
+
+// Columns [k0, k1) of panels [p0, p0 + MP) for `NR` inputs. Partial sums between column blocks go through `partial`
+// (`NR x MP` vectors); the last block writes the activated neurons to `y`. Full panels take the vector `Apply` and the
+// last partial one the scalar `Apply`, lane for lane what `ApplyActivation` does over a row of `y`.
+template <class Activation, int MP, int NR>
+inline void DenseTile(const PackedMatrix& w, int p0, int k0, int k1, const FP* x, size_t ldx, FP* partial, FP* y, size_t ldy) {
+    FPVec acc[MP][NR];
+    for (int p = 0; p < MP; p++) {
+        for (int c = 0; c < NR; c++) acc[p][c] = k0 == 0 ? FPVec {} : SimdLoad(partial + (c * MP + p) * SimdWidth);
+    }
+
+    DensePanelKernel<MP, NR>(w, p0, k0, k1, x, ldx, acc);
+
+    if (k1 < w.Cols) {
+        for (int p = 0; p < MP; p++) {
+            for (int c = 0; c < NR; c++) SimdStore(partial + (c * MP + p) * SimdWidth, acc[p][c]);
+        }
+        return;
+    }
+
+    for (int p = 0; p < MP; p++) {
+        int first = (p0 + p) * SimdWidth;
+        int rows = std::min(SimdWidth, w.Rows - first);
+        for (int c = 0; c < NR; c++) {
+            FP lanes[SimdWidth];
+            SimdStore(lanes, rows == SimdWidth ? Activation::Apply(acc[p][c]) : acc[p][c]);
+            for (int r = 0; r < rows; r++) y[c * ldy + first + r] = rows == SimdWidth ? lanes[r] : Activation::Apply(lanes[r]);
+        }
+    }
+}
+
+// Panels [p0, p0 + MP) against every input, one block of `depth` columns at a time.
+template <class Activation, int MP>
+inline void DensePanelGroup(const PackedMatrix& w, int p0, int depth, const FP* x, size_t ldx, FP* partial, FP* y, size_t ldy, int batch) {
+    for (int k0 = 0; k0 < w.Cols; k0 += depth) {
+        int k1 = std::min(w.Cols, k0 + depth);
+
+        int n = 0;
+        for (; n + KernelBatch <= batch; n += KernelBatch) {
+            DenseTile<Activation, MP, KernelBatch>(w, p0, k0, k1, x + n * ldx, ldx, partial + n * MP * SimdWidth, y + n * ldy, ldy);
+        }
+
+        FP* rest = partial + n * MP * SimdWidth;
+        switch (batch - n) {
+            case 3: DenseTile<Activation, MP, 3>(w, p0, k0, k1, x + n * ldx, ldx, rest, y + n * ldy, ldy); break;
+            case 2: DenseTile<Activation, MP, 2>(w, p0, k0, k1, x + n * ldx, ldx, rest, y + n * ldy, ldy); break;
+            case 1: DenseTile<Activation, MP, 1>(w, p0, k0, k1, x + n * ldx, ldx, rest, y + n * ldy, ldy); break;
+        }
+    }
+}
+
+// Panels from `p0` on, `MP` at a time, then the remaining ones in smaller groups.
+template <class Activation, int MP>
+inline void DensePanels(const PackedMatrix& w, int p0, int depth, const FP* x, size_t ldx, FP* partial, FP* y, size_t ldy, int batch) {
+    for (; p0 + MP <= w.NumPanels(); p0 += MP) DensePanelGroup<Activation, MP>(w, p0, depth, x, ldx, partial, y, ldy, batch);
+    if constexpr (MP > 1) DensePanels<Activation, MP / 2>(w, p0, depth, x, ldx, partial, y, ldy, batch);
+}
+
+// Fully connected layer over a batch (GEMM, or GEMV when `batch == 1`): y[n][i] = Activation(sum_k (x[n][k] * w[i][k] + b[i])),
+// added up with `ConnectionStep`. The bias is added once per incoming connection, the network's convention.
+// `x`/`y` hold one sample per row with strides `ldx`/`ldy`.
+// The connections of a neuron form one sequential chain, so the kernel vectorizes across the neurons of a panel instead,
+// and keeps about eight chains in flight: two panels for `KernelBatch` inputs, or up to eight panels for a single one.
+// Over more than `KernelBatch` inputs the columns go in blocks of `KernelDepth`, each swept over the whole batch.
+template <class Activation>
+inline void DenseLayer(const PackedMatrix& w, const FP* x, size_t ldx, FP* y, size_t ldy, int batch) {
+    int depth = batch > KernelBatch ? KernelDepth : w.Cols;
+
+    FP* partial = nullptr;
+    if (depth < w.Cols) {
+        thread_local std::vector<FP, SimdAllocator<FP>> partials;
+        partials.resize((size_t) (batch + KernelBatch) * 2 * SimdWidth);
+        partial = partials.data();
+    }
+
+    if (batch >= KernelBatch) DensePanels<Activation, 2>(w, 0, depth, x, ldx, partial, y, ldy, batch);
+    else if (batch == 1) DensePanels<Activation, 8>(w, 0, depth, x, ldx, partial, y, ldy, batch);
+    else DensePanels<Activation, 4>(w, 0, depth, x, ldx, partial, y, ldy, batch);
+}
+
+// Same layer straight from the row-major `rows x cols` weights `w`, one neuron after the other.
+template <class Activation>
+inline void DenseLayerRows(const FP* w, const FP* b, int rows, int cols, const FP* x, size_t ldx, FP* y, size_t ldy, int batch) {
+    for (int n = 0; n < batch; n++) {
+        const FP* xs = x + n * ldx;
+        for (int i = 0; i < rows; i++) {
+            FP sum = 0.0;
+            for (int k = 0; k < cols; k++) sum = ConnectionStep(sum, xs[k], w[i * cols + k], b[i]);
+            y[n * ldy + i] = sum;
+        }
+        ApplyActivation<Activation>(y + n * ldy, rows);
+    }
+}
+
+// `DenseLayer` with sizes known at compile time, so small layers unroll completely. Layers that use panels take `packed`
+// when given (the panels of these same weights) and fall back to the row loop otherwise.
+template <int Rows, int Cols, class Activation>
+inline void DenseLayerFixed(const PackedMatrix* packed, const FP* w, const FP* b, const FP* x, size_t ldx, FP* y, size_t ldy, int batch) {
+    if constexpr (KernelUsesPanels<Rows, Cols>) {
+        if (packed) return DenseLayer<Activation>(*packed, x, ldx, y, ldy, batch);
+    }
+    DenseLayerRows<Activation>(w, b, Rows, Cols, x, ldx, y, ldy, batch);
+}
+
+// Weight matrix in compressed sparse rows: only nonzero weights, with their column indices.
+struct SparseMatrix {
+    int Rows = 0;
+    int Cols = 0;
+    std::vector<int> RowStart;
+    std::vector<uint16_t> ColIndex;
+    std::vector<FP> Values;
+
+    static SparseMatrix FromDense(const MatrixView<const FP>& dense) {
+        SparseMatrix out;
+        out.Rows = (int) dense.Rows;
+        out.Cols = (int) dense.Cols;
+        out.RowStart.reserve(dense.Rows + 1);
+        out.RowStart.push_back(0);
+
+        for (size_t i = 0; i < dense.Rows; i++) {
+            for (size_t j = 0; j < dense.Cols; j++) {
+                if (dense[i][j] == 0.0) continue;
+                out.ColIndex.push_back((uint16_t) j);
+                out.Values.push_back(dense[i][j]);
+            }
+            out.RowStart.push_back((int) out.Values.size());
+        }
+        return out;
+    }
+};
+
+// `DenseLayer` over the nonzero weights only. Pruned connections still add the bias, in their place in the chain, which
+// is exactly what the dense layer adds for them (x * 0 + b) for every finite input. That keeps one dependent add per
+// column, the same chain the row kernel waits on, so skipping the multiplies saves little (about 10% with almost every
+// weight pruned, `scptools prune`) and this is only used when asked for (`ControlNetwork::UpdateLayout`).
+template <class Activation>
+inline void SparseLayer(const SparseMatrix& w, const FP* b, const FP* x, size_t ldx, FP* y, size_t ldy, int batch) {
+    for (int n = 0; n < batch; n++) {
+        const FP* xs = x + n * ldx;
+        FP* ys = y + n * ldy;
+
+        for (int i = 0; i < w.Rows; i++) {
+            FP sum = 0.0;
+            int k = 0;
+            for (int next = w.RowStart[i]; next < w.RowStart[i + 1]; next++) {
+                for (; k < w.ColIndex[next]; k++) sum += b[i];
+                sum = ConnectionStep(sum, xs[k], w.Values[next], b[i]);
+                k++;
+            }
+            for (; k < w.Cols; k++) sum += b[i];
+            ys[i] = sum;
+        }
+        ApplyActivation<Activation>(ys, w.Rows);
+    }
+}
@@ -1,9 +1,11 @@
 #include "MainWindow.hpp"
 #include "Config.hpp"
+#include "ControllerExport.hpp"
 #include "TrainingSim.hpp"
 #include "Vec2.hpp"
 
 #include <LLThread.hpp>
+#include <chrono>
 #include <cmath>
 #include <format>
 
@@ -183,16 +185,25 @@ bool MainWindow::TrainingUpdate() {
         return true;
     }
 
-    if (GetKey(olc::R).bPressed) {
-        Training = TrainingSim();
+    if (GetKey(olc::R).bPressed && !PendingTraining.valid()) {
+        PendingTraining = TrainingSim::CreateAsync(Training.Seed + 1);
+    }
+
+    if (PendingTraining.valid() && PendingTraining.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        Training = PendingTraining.get();
     }
 
     if (GetKey(olc::P).bPressed) {
         TrainingPaused = !TrainingPaused;
     }
 
-    if (GetKey(olc::S).bPressed) {
-        Training.SaveToFile();
+    if (GetKey(olc::S).bPressed && !PendingSave) {
+        PendingSave = Training.SaveToFileAsync();
+    }
+
+    if (PendingSave && (PendingSave->IsDone() || GetKey(olc::L).bPressed)) {
+        PendingSave->Wait();
+        PendingSave.reset();
     }
 
     if (GetKey(olc::L).bPressed) {
@@ -200,12 +211,17 @@ bool MainWindow::TrainingUpdate() {
         BestDroneSoFar = Training.Drones[0];
     }
 
+    if (GetKey(olc::E).bPressed) {
+        ControllerExport::ExportToFiles(BestDroneSoFar.Brain, "BestDroneController");
+    }
+
     DrawString({10, 10}, "Hold [ESC] to exit.\nHold [R] to restart training.\nHold [P] to pause/resume training.");
 
     FP avgPenalty = 0.0;
 
     auto duration = ll::TimeFunc([this, &avgPenalty] {
-        if (!TrainingPaused) avgPenalty = Training.TrainGeneration();
+        // The new population is being built on the pool.
+        if (!TrainingPaused && !PendingTraining.valid()) avgPenalty = Training.TrainGeneration();
     });
 
     if (Training.Drones[0].TrainingScore < BestDroneSoFar.TrainingScore) BestDroneSoFar = Training.Drones[0];
@@ -213,6 +229,7 @@ bool MainWindow::TrainingUpdate() {
     DrawString({10, 60}, std::format("Trained for {} generations.", Training.GenerationsDone));
     DrawString({10, 70}, std::format("Using {} threads for training.", SimulationThreads));
     DrawString({10, 80}, std::format("Took {}", duration));
+    DrawString({10, 90}, std::format("Episode lane utilization: {:.1f}%.", Training.LaneStats.Utilization() * 100.0));
 
     DrawString({10, 100}, std::format("Average training loss: {: 5.3f}.", avgPenalty));
     DrawString({10, 110}, std::format("Best drone loss score: {: 5.3f}.", Training.Drones[0].TrainingScore));
@@ -220,8 +237,12 @@ bool MainWindow::TrainingUpdate() {
 
     DrawString({10, 200}, "Press [S] to save current generation to checkpoint file.");
     DrawString({10, 210}, "Press [L] to load checkpoint file.");
+    DrawString({10, 220}, "Press [E] to export best drone so far as a C++ header.");
+
+    if (PendingTraining.valid()) DrawString({10, 250}, "Restarting training...", olc::YELLOW, 2);
+    else if (TrainingPaused) DrawString({10, 250}, "Training paused.", olc::RED, 2);
 
-    if (TrainingPaused) DrawString({10, 250}, "Training paused.", olc::RED, 2);
+    if (PendingSave) DrawString({10, 270}, "Saving checkpoint...", olc::YELLOW);
 
     Sim.SimDrone = &Training.Drones[0];
     
@@ -6,6 +6,9 @@
 #include "Vec2.hpp"
 #include "olcPGE.hpp"
 
+#include <future>
+#include <optional>
+
 class MainWindow : public olc::PixelGameEngine {
     private:
         enum class AppState {
@@ -23,6 +26,11 @@ class MainWindow : public olc::PixelGameEngine {
         PhysicsSim Sim;
         TrainingSim Training;
 
+        // Population being built after [R], replacing `Training` once ready.
+        std::future<TrainingSim> PendingTraining;
+        // Checkpoint being written after [S].
+        std::optional<ll::TaskBatch> PendingSave;
+
         Vec2 CameraPos = {0.0, 0.0};
         float CameraZoom = 0.25;
 
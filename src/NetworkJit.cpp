@@ -0,0 +1,304 @@
+#include "NetworkJit.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define NETWORK_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Util.hpp"
+
+// Base registers of the generated function, following the System V calling convention.
+enum class JitGpr : uint8_t {
+    Rdx = 2,   // scratch
+    Rsi = 6,   // output
+    Rdi = 7,   // input
+};
+
+// SSE2 double opcodes (after the 0x0F escape byte). The prefix selects scalar (sd) or packed (pd).
+static constexpr uint8_t JitPrefixSd = 0xF2;
+static constexpr uint8_t JitPrefixPd = 0x66;
+static constexpr uint8_t JitOpLoad = 0x10;
+static constexpr uint8_t JitOpStore = 0x11;
+static constexpr uint8_t JitOpUnpackLow = 0x14;
+static constexpr uint8_t JitOpMovAligned = 0x28;  // movapd, from a register or 16-byte aligned memory
+static constexpr uint8_t JitOpAdd = 0x58;
+static constexpr uint8_t JitOpMul = 0x59;
+static constexpr uint8_t JitOpXor = 0x57;
+static constexpr uint8_t JitOpMax = 0x5F;
+
+// xmm0 holds the broadcast input, xmm1 is a temporary and xmm2-xmm15 accumulate two neurons each.
+static constexpr int JitFirstAccumulator = 2;
+static constexpr int JitNumAccumulators = 14;
+
+static constexpr FP JitLeakySlope = LeakyReLUActivation::Slope;
+
+class JitAssembler {
+    public:
+        std::vector<uint8_t> Code;
+
+        // Adds a 16-byte aligned pair of constants, to be used as a packed operand.
+        size_t AddConstantPair(FP low, FP high) {
+            Constants.push_back(low);
+            Constants.push_back(high);
+            return Constants.size() / 2 - 1;
+        }
+
+        void Bytes(std::initializer_list<uint8_t> bytes) {
+            Code.insert(Code.end(), bytes);
+        }
+
+        // op xmm, [base + disp32]  /  op [base + disp32], xmm
+        void Memory(uint8_t prefix, uint8_t opcode, int xmm, JitGpr base, int32_t disp) {
+            Instruction(prefix, opcode, xmm, 0);
+            Bytes({ModRM(0b10, xmm, (int) base)});
+            Disp32(disp);
+        }
+
+        // op xmm, [rip + constant pair]
+        void Constant(uint8_t prefix, uint8_t opcode, int xmm, size_t pairIndex) {
+            Instruction(prefix, opcode, xmm, 0);
+            Bytes({ModRM(0b00, xmm, 0b101)});
+            Fixups.push_back({Code.size(), pairIndex});
+            Disp32(0);
+        }
+
+        // vfmadd231pd xmm, src, [rip + constant pair]: xmm = src * constant + xmm, rounded once.
+        void FmaConstant(int xmm, int src, size_t pairIndex) {
+            // Three-byte VEX prefix: inverted xmm extension bit, map 0F38; W1, inverted `src`, 128 bits, implied 66.
+            Bytes({0xC4, (uint8_t) ((xmm >= 8 ? 0x00 : 0x80) | 0x60 | 0x02), (uint8_t) (0x80 | ((~src & 0xF) << 3) | 0x01), 0xB8});
+            Bytes({ModRM(0b00, xmm, 0b101)});
+            Fixups.push_back({Code.size(), pairIndex});
+            Disp32(0);
+        }
+
+        // op xmm, xmm
+        void Register(uint8_t prefix, uint8_t opcode, int dst, int src) {
+            Instruction(prefix, opcode, dst, src);
+            Bytes({ModRM(0b11, dst, src)});
+        }
+
+        // Appends the constant pool after the code and resolves every RIP-relative displacement.
+        // The image is expected to be loaded at a page-aligned address.
+        std::vector<uint8_t> Link() {
+            constexpr size_t pairSize = 2 * sizeof(FP);
+
+            std::vector<uint8_t> image = Code;
+            image.resize((image.size() + pairSize - 1) / pairSize * pairSize, 0xCC);
+
+            size_t poolStart = image.size();
+            image.resize(poolStart + Constants.size() * sizeof(FP));
+            std::memcpy(image.data() + poolStart, Constants.data(), Constants.size() * sizeof(FP));
+
+            for (auto& [position, index] : Fixups) {
+                auto target = (int64_t) (poolStart + index * pairSize);
+                auto disp = (int32_t) (target - (int64_t) (position + 4));
+                std::memcpy(image.data() + position, &disp, 4);
+            }
+            return image;
+        }
+
+    private:
+        std::vector<FP> Constants;
+        std::vector<std::pair<size_t, size_t>> Fixups;
+
+        static uint8_t ModRM(int mod, int reg, int rm) {
+            return (uint8_t) ((mod << 6) | ((reg & 7) << 3) | (rm & 7));
+        }
+
+        // Mandatory prefix, REX for xmm8-xmm15, escape and opcode.
+        void Instruction(uint8_t prefix, uint8_t opcode, int reg, int rm) {
+            Bytes({prefix});
+            if (reg >= 8 || rm >= 8) {
+                Bytes({(uint8_t) (0x40 | (reg >= 8 ? 0x4 : 0) | (rm >= 8 ? 0x1 : 0))});
+            }
+            Bytes({0x0F, opcode});
+        }
+
+        void Disp32(int32_t disp) {
+            uint8_t bytes[4];
+            std::memcpy(bytes, &disp, 4);
+            Code.insert(Code.end(), bytes, bytes + 4);
+        }
+};
+
+// One fully unrolled layer: out[i] = LeakyReLU(sum_j (in[j] * w[i][j] + b[i])).
+// Neurons are computed two per register and up to 28 at a time to keep independent chains in flight. Each connection
+// is `ConnectionStep`, the fused in[j] * w[i][j] + b[i] added to the accumulator, so results match `EvaluateNetwork` exactly.
+static void EmitLayer(JitAssembler& as, JitGpr inBase, int inOffset, int inSize, JitGpr outBase, int outOffset, int outSize, const FP* weights, const FP* biases, size_t slope) {
+    for (int first = 0; first < outSize; first += 2 * JitNumAccumulators) {
+        int count = std::min(outSize - first, 2 * JitNumAccumulators);
+        int pairs = (count + 1) / 2;
+
+        auto weight = [&] (int i, int j) { return i < outSize ? weights[i * inSize + j] : 0.0; };
+        auto bias = [&] (int i) { return i < outSize ? biases[i] : 0.0; };
+
+        std::vector<size_t> biasPairs;
+        for (int p = 0; p < pairs; p++) {
+            int i = first + 2 * p;
+            biasPairs.push_back(as.AddConstantPair(bias(i), bias(i + 1)));
+            as.Register(JitPrefixPd, JitOpXor, JitFirstAccumulator + p, JitFirstAccumulator + p);
+        }
+
+        for (int j = 0; j < inSize; j++) {
+            as.Memory(JitPrefixSd, JitOpLoad, 0, inBase, (inOffset + j) * sizeof(FP));
+            as.Register(JitPrefixPd, JitOpUnpackLow, 0, 0);
+
+            for (int p = 0; p < pairs; p++) {
+                int i = first + 2 * p;
+                as.Constant(JitPrefixPd, JitOpMovAligned, 1, biasPairs[p]);
+                as.FmaConstant(1, 0, as.AddConstantPair(weight(i, j), weight(i + 1, j)));
+                as.Register(JitPrefixPd, JitOpAdd, JitFirstAccumulator + p, 1);
+            }
+        }
+
+        for (int p = 0; p < pairs; p++) {
+            int i = first + 2 * p;
+            int acc = JitFirstAccumulator + p;
+
+            // max(x, 0.1 * x) is the leaky ReLU for a slope below 1, including its handling of zeros and NaN.
+            as.Register(JitPrefixPd, JitOpMovAligned, 1, acc);
+            as.Constant(JitPrefixPd, JitOpMul, 1, slope);
+            as.Register(JitPrefixPd, JitOpMax, acc, 1);
+
+            // Unaligned packed store, or only the low lane for the last neuron of an odd-sized layer.
+            auto prefix = i + 1 < outSize ? JitPrefixPd : JitPrefixSd;
+            as.Memory(prefix, JitOpStore, acc, outBase, (outOffset + i) * sizeof(FP));
+        }
+    }
+}
+
+bool NetworkJit::Supported() {
+#ifdef NETWORK_JIT_X86_64
+    // Only the leaky ReLU is emitted, other activations stay on the interpreted path.
+    // Connections are fused multiply-adds, so CPUs without FMA stay on it too.
+    return std::is_same_v<FP, double> && ControlNetwork::ActivationType::Kind == ActivationKind::LeakyReLU && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+std::shared_ptr<const NetworkJit> NetworkJit::Compile(const ControlNetwork& net) {
+#ifdef NETWORK_JIT_X86_64
+    if (!Supported()) return nullptr;
+
+    JitAssembler as;
+    auto slope = as.AddConstantPair(JitLeakySlope, JitLeakySlope);
+
+    // Avoid SSE/AVX transition penalties when called from AVX code (every FMA CPU has AVX).
+    as.Bytes({0xC5, 0xF8, 0x77});
+
+    EmitLayer(as, JitGpr::Rdi, 0, InputSize, JitGpr::Rdx, 0, Hidden1Size, net.InToH1Weights().Data, net.H1Biases().data(), slope);
+    EmitLayer(as, JitGpr::Rdx, 0, Hidden1Size, JitGpr::Rdx, Hidden1Size, Hidden2Size, net.H1ToH2Weights().Data, net.H2Biases().data(), slope);
+    EmitLayer(as, JitGpr::Rdx, Hidden1Size, Hidden2Size, JitGpr::Rsi, 0, OutputSize, net.H2ToOutWeights().Data, net.OutBiases().data(), slope);
+    as.Bytes({0xC3});
+
+    auto codeSize = as.Code.size();
+    auto image = as.Link();
+
+    auto pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    auto mappedSize = (image.size() + pageSize - 1) / pageSize * pageSize;
+
+    void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+
+    std::memcpy(memory, image.data(), image.size());
+
+    if (mprotect(memory, mappedSize, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, mappedSize);
+        return nullptr;
+    }
+
+    return std::shared_ptr<const NetworkJit>(new NetworkJit(memory, mappedSize, codeSize));
+#else
+    (void) net;
+    return nullptr;
+#endif
+}
+
+NetworkJit::NetworkJit(void* memory, size_t mappedSize, size_t codeSize) : Memory(memory), MappedSize(mappedSize), CodeSize(codeSize) {
+    Function = reinterpret_cast<EvalFunc>(memory);
+}
+
+NetworkJit::~NetworkJit() {
+#ifdef NETWORK_JIT_X86_64
+    munmap(Memory, MappedSize);
+#endif
+}
+
+double NetworkJit::CostModel::BreakEvenEvaluations() const {
+    double savedPerEval = InterpretedEvalSeconds - JitEvalSeconds;
+    if (savedPerEval <= 0.0) return std::numeric_limits<double>::infinity();
+    return CompileSeconds / savedPerEval;
+}
+
+bool NetworkJit::CostModel::PaysOff(double expectedEvaluations) const {
+    return expectedEvaluations > BreakEvenEvaluations();
+}
+
+const NetworkJit::CostModel& NetworkJit::GetCostModel() {
+    static const CostModel model = [] {
+        constexpr int numNetworks = 32;
+        constexpr int numInputs = SimulationsPerDrone * 32;
+        constexpr int evalRepeats = 64;
+
+        CostModel result;
+        if (!Supported()) return result;
+
+        std::mt19937 gen {12345};
+        std::normal_distribution<FP> dist {0.0, 2.0};
+
+        std::vector<std::array<FP, InputSize>> inputs(numInputs);
+        for (auto& input : inputs) {
+            for (auto& x : input) x = dist(gen);
+        }
+
+        std::vector<ControlNetwork> nets(numNetworks);
+        std::vector<std::shared_ptr<const NetworkJit>> compiled(numNetworks);
+
+        result.CompileSeconds = MeasureSeconds([&] {
+            for (int n = 0; n < numNetworks; n++) compiled[n] = Compile(nets[n]);
+            compiled.clear();
+        }) / numNetworks;
+
+        auto jit = Compile(nets[0]);
+        if (!jit) return CostModel {};
+
+        // Both paths are timed the way training calls them, one batch of lockstep episodes at a time.
+        std::vector<FP> outputs(numInputs * OutputSize);
+        FP checksum = 0.0;
+        constexpr double numEvals = (double) numInputs * evalRepeats;
+
+        result.InterpretedEvalSeconds = MeasureSeconds([&] {
+            for (int r = 0; r < evalRepeats; r++) {
+                for (int n = 0; n + (int) SimulationsPerDrone <= numInputs; n += SimulationsPerDrone) {
+                    nets[0].EvaluateNetworkBatch(inputs[n].data(), outputs.data() + n * OutputSize, SimulationsPerDrone);
+                }
+                checksum += outputs[0];
+            }
+        }) / numEvals;
+
+        result.JitEvalSeconds = MeasureSeconds([&] {
+            for (int r = 0; r < evalRepeats; r++) {
+                for (int n = 0; n + (int) SimulationsPerDrone <= numInputs; n += SimulationsPerDrone) {
+                    jit->EvaluateNetworkBatch(inputs[n].data(), outputs.data() + n * OutputSize, SimulationsPerDrone);
+                }
+                checksum -= outputs[0];
+            }
+        }) / numEvals;
+
+        // Keeps the timed loops from being optimized out.
+        if (checksum == std::numeric_limits<FP>::infinity()) result.JitEvalSeconds = 0.0;
+        return result;
+    }();
+    return model;
+}
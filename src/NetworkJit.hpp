@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#include "Config.hpp"
+#include "ControlNetwork.hpp"
+
+// Compiles the current weights of a `ControlNetwork` into a specialized x86-64 routine:
+// fully unrolled, weights and biases as RIP-relative constants, bias and leaky ReLU fused into each neuron.
+// The generated code adds each neuron's connections in the order of `ConnectionStep`, so it returns the bits of `EvaluateNetwork`.
+// On other architectures `Compile` returns `nullptr` and callers keep using `EvaluateNetwork`.
+class NetworkJit {
+    public:
+        // Measured costs used to decide when compiling a network pays off.
+        struct CostModel {
+            double CompileSeconds = 0.0;
+            double InterpretedEvalSeconds = 0.0;
+            double JitEvalSeconds = 0.0;
+
+            // Number of evaluations after which compiling is cheaper than interpreting.
+            double BreakEvenEvaluations() const;
+            bool PaysOff(double expectedEvaluations) const;
+        };
+
+        // True if this build can generate and execute code.
+        static bool Supported();
+
+        // Returns `nullptr` if JIT is not supported or the executable memory could not be mapped.
+        static std::shared_ptr<const NetworkJit> Compile(const ControlNetwork& net);
+
+        // Measured once per process on random networks and inputs, and cached.
+        static const CostModel& GetCostModel();
+
+        NetworkJit(const NetworkJit&) = delete;
+        NetworkJit& operator =(const NetworkJit&) = delete;
+
+        ~NetworkJit();
+
+        std::array<FP, OutputSize> EvaluateNetwork(const std::array<FP, InputSize>& input) const {
+            std::array<FP, OutputSize> output;
+            FP scratch[Hidden1Size + Hidden2Size];
+            Function(input.data(), output.data(), scratch);
+            return output;
+        }
+
+        void EvaluateNetworkBatch(const FP* inputs, FP* outputs, int count) const {
+            FP scratch[Hidden1Size + Hidden2Size];
+            for (int n = 0; n < count; n++) {
+                Function(inputs + n * InputSize, outputs + n * OutputSize, scratch);
+            }
+        }
+
+        size_t GetCodeSize() const { return CodeSize; }
+
+    private:
+        using EvalFunc = void (*)(const FP* input, FP* output, FP* scratch);
+
+        NetworkJit(void* memory, size_t mappedSize, size_t codeSize);
+
+        void* Memory;
+        size_t MappedSize;
+        size_t CodeSize;
+        EvalFunc Function;
+};
@@ -6,14 +6,44 @@
 #include <numbers>
 #include <algorithm>
 
+HeadingDroneState::HeadingDroneState(const DroneState& state) : DroneState(state) {
+    HeadingCos = std::cos(DirectionAngle);
+    HeadingSin = std::sin(DirectionAngle);
+}
+
 void PhysicsSim::DoSimulationStep(FP deltaT) {
-    const auto& [thrustL, thrustR] = RequestedThrust;
+    IntegrateState(*SimDrone, RequestedThrust, deltaT);
+}
+
+void PhysicsSim::ManualControlStep(FP left, FP right, FP deltaT) {
+    UpdateThrust(RequestedThrust, left, right, deltaT);
+}
+
+void PhysicsSim::NetworkControlStep(const Vec2& target, FP deltaT) {
+    ControllerStep([this] (const std::array<FP, InputSize>& input) {
+        return SimDrone->Brain.EvaluateNetwork(input);
+    }, target, deltaT);
+}
+
+std::array<FP, InputSize> PhysicsSim::GetNetworkInputs(const Vec2& target) const {
+    return NetworkInputs(*SimDrone, target);
+}
+
+void PhysicsSim::Reset() {
+    SimDrone->Position = 0;
+    SimDrone->Velocity = 0;
+    SimDrone->AngularVelocity = 0;
+    SimDrone->DirectionAngle = 0;
+}
+
+void PhysicsSim::IntegrateState(DroneState& state, const std::array<FP, 2>& thrust, FP deltaT) {
+    const auto& [thrustL, thrustR] = thrust;
 
     Vec2 totalForces;
 
     totalForces += Gravity;
 
-    auto thrustForce = Vec2(0.0, thrustL + thrustR).Rotated(SimDrone->DirectionAngle);
+    auto thrustForce = Vec2(0.0, thrustL + thrustR).Rotated(state.DirectionAngle);
 
     thrustForce = thrustForce * DroneThrust;
     
@@ -21,19 +51,82 @@ void PhysicsSim::DoSimulationStep(FP deltaT) {
 
     auto acceleration = totalForces / DroneMass;
 
-    SimDrone->Velocity += acceleration * deltaT;
-    SimDrone->Position += SimDrone->Velocity * deltaT;
+    state.Velocity += acceleration * deltaT;
+    state.Position += state.Velocity * deltaT;
 
     FP torqueImbalance = (thrustR - thrustL) * DroneTorqueMultiplier;
 
     FP angularAcceleration = torqueImbalance / DroneMomentOfInertia;
 
-    SimDrone->AngularVelocity += angularAcceleration * deltaT;
-    SimDrone->DirectionAngle += SimDrone->AngularVelocity * deltaT;
-    SimDrone->DirectionAngle = std::fmod(SimDrone->DirectionAngle, 2.0 * std::numbers::pi);
+    state.AngularVelocity += angularAcceleration * deltaT;
+    state.DirectionAngle += state.AngularVelocity * deltaT;
+    state.DirectionAngle = std::fmod(state.DirectionAngle, 2.0 * std::numbers::pi);
 }
 
-void PhysicsSim::ManualControlStep(FP left, FP right, FP deltaT) {
+// Linear acceleration of a drone headed at `angle` with the summed thrust of both motors.
+static Vec2 ThrustAcceleration(FP angle, FP thrustSum) {
+    return (Gravity + Vec2(0.0, thrustSum).Rotated(angle) * DroneThrust) / DroneMass;
+}
+
+void PhysicsSim::IntegrateState(DroneState& state, const std::array<FP, 2>& thrust, FP deltaT, Integrator integrator) {
+    const auto& [thrustL, thrustR] = thrust;
+
+    FP thrustSum = thrustL + thrustR;
+    FP angularAcceleration = (thrustR - thrustL) * DroneTorqueMultiplier / DroneMomentOfInertia;
+
+    // The angular acceleration is constant over the step, so the angle is a parabola in time; only the
+    // linear motion, whose acceleration depends on the angle, differs between the integrators.
+    auto angleAt = [&] (FP t) {
+        return state.DirectionAngle + state.AngularVelocity * t + 0.5 * angularAcceleration * t * t;
+    };
+
+    switch (integrator) {
+        case Integrator::SemiImplicitEuler:
+            IntegrateState(state, thrust, deltaT);
+            return;
+
+        case Integrator::VelocityVerlet: {
+            Vec2 a0 = ThrustAcceleration(state.DirectionAngle, thrustSum);
+            Vec2 a1 = ThrustAcceleration(angleAt(deltaT), thrustSum);
+
+            state.Position += state.Velocity * deltaT + a0 * (0.5 * deltaT * deltaT);
+            state.Velocity += (a0 + a1) * (0.5 * deltaT);
+            break;
+        }
+
+        case Integrator::RK2: {
+            Vec2 a0 = ThrustAcceleration(state.DirectionAngle, thrustSum);
+            Vec2 vMid = state.Velocity + a0 * (0.5 * deltaT);
+            Vec2 aMid = ThrustAcceleration(angleAt(0.5 * deltaT), thrustSum);
+
+            state.Position += vMid * deltaT;
+            state.Velocity += aMid * deltaT;
+            break;
+        }
+
+        case Integrator::RK4: {
+            // Stages 2 and 3 share the midpoint angle, so their accelerations are equal.
+            Vec2 a1 = ThrustAcceleration(state.DirectionAngle, thrustSum);
+            Vec2 a2 = ThrustAcceleration(angleAt(0.5 * deltaT), thrustSum);
+            Vec2 a4 = ThrustAcceleration(angleAt(deltaT), thrustSum);
+
+            Vec2 v1 = state.Velocity;
+            Vec2 v2 = state.Velocity + a1 * (0.5 * deltaT);
+            Vec2 v3 = state.Velocity + a2 * (0.5 * deltaT);
+            Vec2 v4 = state.Velocity + a2 * deltaT;
+
+            state.Position += (v1 + v2 * 2.0 + v3 * 2.0 + v4) * (deltaT / 6.0);
+            state.Velocity += (a1 + a2 * 4.0 + a4) * (deltaT / 6.0);
+            break;
+        }
+    }
+
+    state.DirectionAngle = angleAt(deltaT);
+    state.AngularVelocity += angularAcceleration * deltaT;
+    state.DirectionAngle = std::fmod(state.DirectionAngle, 2.0 * std::numbers::pi);
+}
+
+void PhysicsSim::UpdateThrust(std::array<FP, 2>& thrust, FP left, FP right, FP deltaT) {
     //RequestedThrust[0] = std::clamp(left, 0.0, 1.0);
     //RequestedThrust[1] = std::clamp(right, 0.0, 1.0);
 
@@ -42,43 +135,92 @@ void PhysicsSim::ManualControlStep(FP left, FP right, FP deltaT) {
 
     FP thrustChange = DroneThrustChangeSpeed * deltaT;
 
-    if (left > RequestedThrust[0] + thrustChange) {
-        RequestedThrust[0] += thrustChange;
+    if (left > thrust[0] + thrustChange) {
+        thrust[0] += thrustChange;
     }
-    else if (left < RequestedThrust[0] - thrustChange) {
-        RequestedThrust[0] -= thrustChange;
+    else if (left < thrust[0] - thrustChange) {
+        thrust[0] -= thrustChange;
     }
     else {
-        RequestedThrust[0] = left;
+        thrust[0] = left;
     }
 
-    if (right > RequestedThrust[1] + thrustChange) {
-        RequestedThrust[1] += thrustChange;
+    if (right > thrust[1] + thrustChange) {
+        thrust[1] += thrustChange;
     }
-    else if (right < RequestedThrust[1] - thrustChange) {
-        RequestedThrust[1] -= thrustChange;
+    else if (right < thrust[1] - thrustChange) {
+        thrust[1] -= thrustChange;
     }
     else {
-        RequestedThrust[1] = right;
+        thrust[1] = right;
     }
 }
 
-void PhysicsSim::NetworkControlStep(const Vec2& target, FP deltaT) {
-    auto difX = SimDrone->Position.x - target.x;
-    auto difY = SimDrone->Position.y - target.y;
-    auto velX = SimDrone->Velocity.x;
-    auto velY = SimDrone->Velocity.y;
-    auto angVel = SimDrone->AngularVelocity;
-    auto sinAng = std::sin(SimDrone->DirectionAngle);
-    auto cosAng = std::cos(SimDrone->DirectionAngle);
-
-    auto thrusters = SimDrone->Brain.EvaluateNetwork({difX, difY, velX, velY, angVel, sinAng, cosAng});
-    ManualControlStep(thrusters[0], thrusters[1], deltaT);
+std::array<FP, InputSize> PhysicsSim::NetworkInputs(const DroneState& state, const Vec2& target) {
+    auto difX = state.Position.x - target.x;
+    auto difY = state.Position.y - target.y;
+    auto velX = state.Velocity.x;
+    auto velY = state.Velocity.y;
+    auto angVel = state.AngularVelocity;
+    auto sinAng = std::sin(state.DirectionAngle);
+    auto cosAng = std::cos(state.DirectionAngle);
+
+    return {difX, difY, velX, velY, angVel, sinAng, cosAng};
 }
 
-void PhysicsSim::Reset() {
-    SimDrone->Position = 0;
-    SimDrone->Velocity = 0;
-    SimDrone->AngularVelocity = 0;
-    SimDrone->DirectionAngle = 0;
-}
\ No newline at end of file
+void PhysicsSim::HeadingStep(HeadingDroneState& state, std::array<FP, 2>& thrust, FP left, FP right, FP deltaT) {
+    UpdateThrust(thrust, left, right, deltaT);
+
+    const auto& [thrustL, thrustR] = thrust;
+    FP thrustForce = (thrustL + thrustR) * DroneThrust;
+
+    // `Vec2(0, thrust).Rotated(angle)`, with the current heading.
+    Vec2 totalForces = Gravity + Vec2(-thrustForce * state.HeadingSin, thrustForce * state.HeadingCos);
+
+    auto acceleration = totalForces / DroneMass;
+
+    state.Velocity += acceleration * deltaT;
+    state.Position += state.Velocity * deltaT;
+
+    FP torqueImbalance = (thrustR - thrustL) * DroneTorqueMultiplier;
+    FP angularAcceleration = torqueImbalance / DroneMomentOfInertia;
+
+    state.AngularVelocity += angularAcceleration * deltaT;
+
+    FP delta = state.AngularVelocity * deltaT;
+    state.DirectionAngle += delta;
+    if (std::abs(state.DirectionAngle) >= 2.0 * std::numbers::pi) {
+        state.DirectionAngle = std::fmod(state.DirectionAngle, 2.0 * std::numbers::pi);
+    }
+
+    FP deltaCos, deltaSin;
+    if (std::abs(delta) <= HeadingSeriesLimit) {
+        FP d2 = delta * delta;
+        deltaCos = 1.0 - d2 * (1.0 / 2) * (1.0 - d2 * (1.0 / 12) * (1.0 - d2 * (1.0 / 30) * (1.0 - d2 * (1.0 / 56) * (1.0 - d2 * (1.0 / 90)))));
+        deltaSin = delta * (1.0 - d2 * (1.0 / 6) * (1.0 - d2 * (1.0 / 20) * (1.0 - d2 * (1.0 / 42) * (1.0 - d2 * (1.0 / 72) * (1.0 - d2 * (1.0 / 110))))));
+    }
+    else {
+        deltaCos = std::cos(delta);
+        deltaSin = std::sin(delta);
+    }
+
+    FP c = state.HeadingCos * deltaCos - state.HeadingSin * deltaSin;
+    FP n = state.HeadingSin * deltaCos + state.HeadingCos * deltaSin;
+
+    if (++state.StepsSinceRenormalize == HeadingRenormalizeInterval) {
+        FP invLength = 1.0 / std::sqrt(c * c + n * n);
+        c *= invLength;
+        n *= invLength;
+        state.StepsSinceRenormalize = 0;
+    }
+
+    state.HeadingCos = c;
+    state.HeadingSin = n;
+}
+
+std::array<FP, InputSize> PhysicsSim::NetworkInputs(const HeadingDroneState& state, const Vec2& target) {
+    auto difX = state.Position.x - target.x;
+    auto difY = state.Position.y - target.y;
+
+    return {difX, difY, state.Velocity.x, state.Velocity.y, state.AngularVelocity, state.HeadingSin, state.HeadingCos};
+}
@@ -2,10 +2,15 @@
 
 #include "Drone.hpp"
 
+#include <vector>
+
 struct PhysicsSim {
     Drone* SimDrone = nullptr;
     std::array<FP, 2> RequestedThrust = {0};
 
+    // When set, every network input produced by `NetworkControlStep` is appended here (used for calibration).
+    std::vector<std::array<FP, InputSize>>* InputLog = nullptr;
+
     PhysicsSim() = default;
     PhysicsSim(Drone& drone) : SimDrone(&drone) { Reset(); }
 
@@ -14,5 +19,38 @@ struct PhysicsSim {
     void ManualControlStep(FP left, FP right, FP deltaT);
     void NetworkControlStep(const Vec2& target, FP deltaT);
 
+    // Same as `NetworkControlStep`, but thrust comes from `controller(inputs)` instead of the drone's brain.
+    template <class C>
+    requires requires (const C& c, const std::array<FP, InputSize>& in) {
+        {c(in)} -> std::convertible_to<std::array<FP, OutputSize>>;
+    }
+    void ControllerStep(const C& controller, const Vec2& target, FP deltaT) {
+        auto input = GetNetworkInputs(target);
+        if (InputLog != nullptr) InputLog->push_back(input);
+
+        auto thrusters = controller(input);
+        ManualControlStep(thrusters[0], thrusters[1], deltaT);
+    }
+
+    std::array<FP, InputSize> GetNetworkInputs(const Vec2& target) const;
+
     void Reset();
+
+    // Stateless versions of the steps above, for simulations that keep their own `DroneState` and thrust.
+    static void IntegrateState(DroneState& state, const std::array<FP, 2>& thrust, FP deltaT);
+    // Same step with another integrator; thrust is held constant over the step. `SemiImplicitEuler` is the version above.
+    static void IntegrateState(DroneState& state, const std::array<FP, 2>& thrust, FP deltaT, Integrator integrator);
+    static void UpdateThrust(std::array<FP, 2>& thrust, FP left, FP right, FP deltaT);
+    static std::array<FP, InputSize> NetworkInputs(const DroneState& state, const Vec2& target);
+
+    // Fused `UpdateThrust` + `IntegrateState` on a drone that keeps its heading as (cos, sin): the heading feeds the thrust
+    // rotation and the network inputs directly, and is rotated by the small per-step angle change with short series,
+    // so a step needs no trigonometric calls. `DirectionAngle` is still accumulated (and wrapped like `IntegrateState`)
+    // for scoring and rendering.
+    static void HeadingStep(HeadingDroneState& state, std::array<FP, 2>& thrust, FP left, FP right, FP deltaT);
+    // Steps between renormalizations of the incrementally rotated heading; each rotation adds about one ulp of length error.
+    static constexpr int HeadingRenormalizeInterval = 32;
+    // Largest per-step angle change rotated with the series in `HeadingStep`, which are accurate to an ulp up to it.
+    static constexpr FP HeadingSeriesLimit = 0.25;
+    static std::array<FP, InputSize> NetworkInputs(const HeadingDroneState& state, const Vec2& target);
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "PolicyField.hpp"
+#include "Config.hpp"
+#include "PhysicsSim.hpp"
+
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <numbers>
+
+// Points generated and evaluated per task, enough to amortize the task overhead and keep inputs in L2.
+static constexpr size_t PolicyFieldChunkSize = 8192;
+
+static constexpr uint32_t PolicyFieldVersion = 1;
+
+static constexpr std::string_view PolicyAxisNames[] = {
+    "offset-x",
+    "offset-y",
+    "velocity-x",
+    "velocity-y",
+    "angular-velocity",
+    "angle",
+};
+
+std::string_view PolicyAxisName(PolicyAxis axis) {
+    return PolicyAxisNames[(int) axis];
+}
+
+std::optional<PolicyAxis> PolicyAxisFromName(std::string_view name) {
+    for (int i = 0; i < (int) std::size(PolicyAxisNames); i++) {
+        if (PolicyAxisNames[i] == name) return (PolicyAxis) i;
+    }
+    return std::nullopt;
+}
+
+PolicyAxisRange DefaultPolicyAxisRange(PolicyAxis axis, int steps) {
+    switch (axis) {
+        case PolicyAxis::OffsetX:
+        case PolicyAxis::OffsetY:
+            return {axis, -TrainingMaxCoords, TrainingMaxCoords, steps};
+        case PolicyAxis::VelocityX:
+        case PolicyAxis::VelocityY:
+            return {axis, -2.0 * PhysicsSimTargetDroneSpeed, 2.0 * PhysicsSimTargetDroneSpeed, steps};
+        case PolicyAxis::AngularVelocity:
+            return {axis, -4.0, 4.0, steps};
+        case PolicyAxis::Angle:
+            return {axis, -std::numbers::pi, std::numbers::pi, steps};
+    }
+    return {axis, 0.0, 0.0, steps};
+}
+
+static void SetAxisValue(DroneState& state, PolicyAxis axis, FP value) {
+    switch (axis) {
+        case PolicyAxis::OffsetX: state.Position.x = value; break;
+        case PolicyAxis::OffsetY: state.Position.y = value; break;
+        case PolicyAxis::VelocityX: state.Velocity.x = value; break;
+        case PolicyAxis::VelocityY: state.Velocity.y = value; break;
+        case PolicyAxis::AngularVelocity: state.AngularVelocity = value; break;
+        case PolicyAxis::Angle: state.DirectionAngle = value; break;
+    }
+}
+
+size_t PolicyField::PointCount() const {
+    size_t count = 1;
+    for (auto& axis : Axes) count *= std::max(axis.Steps, 1);
+    return count;
+}
+
+DroneState PolicyField::PointState(size_t index, int* steps) const {
+    DroneState state = Base;
+
+    for (int a = (int) Axes.size() - 1; a >= 0; a--) {
+        int axisSteps = std::max(Axes[a].Steps, 1);
+        int step = (int) (index % axisSteps);
+        index /= axisSteps;
+
+        SetAxisValue(state, Axes[a].Axis, Axes[a].Value(step));
+        if (steps != nullptr) steps[a] = step;
+    }
+
+    return state;
+}
+
+void PolicyField::Evaluate(const ControlNetwork& net, ll::ThreadPool& pool) {
+    size_t count = PointCount();
+    Thrust.resize(count);
+
+    // The network sees the drone relative to the target, so the target stays at the origin and offsets move the drone.
+    const Vec2 target {0.0, 0.0};
+
+    // Input scratch per runner, reused by all of its chunks; each chunk is evaluated in batches of `PolicyFieldChunkSize`.
+    std::vector<std::vector<std::array<FP, InputSize>>> scratch(pool.GetMaxRunners());
+
+    pool.ParallelFor(0, (int) count, PolicyFieldChunkSize, scratch, [&] (ll::IndexRange range, auto& inputs) {
+        for (size_t first = range.Begin; first < (size_t) range.End; first += PolicyFieldChunkSize) {
+            size_t n = std::min(PolicyFieldChunkSize, range.End - first);
+            inputs.resize(n);
+
+            for (size_t i = 0; i < n; i++) inputs[i] = PhysicsSim::NetworkInputs(PointState(first + i), target);
+
+            net.EvaluateNetworkBatch(std::span(inputs.data(), n), std::span(Thrust.data() + first, n));
+        }
+    }, ll::Partition::Static);
+}
+
+bool PolicyField::WriteCsv(const char* fileName) const {
+    std::ofstream file {fileName};
+    if (!file.is_open()) return false;
+
+    for (auto& axis : Axes) file << PolicyAxisName(axis.Axis) << ",";
+    file << "thrust-left,thrust-right\n";
+
+    std::vector<int> steps(Axes.size());
+    for (size_t i = 0; i < Thrust.size(); i++) {
+        PointState(i, steps.data());
+        for (size_t a = 0; a < Axes.size(); a++) file << Axes[a].Value(steps[a]) << ",";
+        file << Thrust[i][0] << "," << Thrust[i][1] << "\n";
+    }
+
+    return file.good();
+}
+
+bool PolicyField::WriteBinary(const char* fileName) const {
+    std::ofstream file {fileName, std::ios::binary};
+    if (!file.is_open()) return false;
+
+    auto write = [&file] (const auto& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    file.write("SCPF", 4);
+    write(PolicyFieldVersion);
+    write((uint32_t) sizeof(FP));
+    write((uint32_t) Axes.size());
+
+    for (auto& axis : Axes) {
+        write((uint32_t) axis.Axis);
+        write((double) axis.Min);
+        write((double) axis.Max);
+        write((uint32_t) axis.Steps);
+    }
+
+    write((uint64_t) Thrust.size());
+    file.write(reinterpret_cast<const char*>(Thrust.data()), Thrust.size() * sizeof(Thrust[0]));
+
+    return file.good();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ControlNetwork.hpp"
+#include "Drone.hpp"
+
+namespace ll {
+    class ThreadPool;
+}
+
+// Drone state variables a policy field can sweep. Offsets are the drone position relative to the target.
+enum class PolicyAxis {
+    OffsetX,
+    OffsetY,
+    VelocityX,
+    VelocityY,
+    AngularVelocity,
+    Angle,
+};
+
+struct PolicyAxisRange {
+    PolicyAxis Axis;
+    FP Min;
+    FP Max;
+    int Steps;
+
+    FP Value(int step) const {
+        return Steps > 1 ? Min + (Max - Min) * step / (Steps - 1) : Min;
+    }
+};
+
+std::string_view PolicyAxisName(PolicyAxis axis);
+std::optional<PolicyAxis> PolicyAxisFromName(std::string_view name);
+
+// Default sweep range for each axis: training target area, and speeds the trained controllers actually reach.
+PolicyAxisRange DefaultPolicyAxisRange(PolicyAxis axis, int steps);
+
+// Thrust outputs of a controller over a dense grid of drone states.
+// Variables not swept keep their value in `Base` (hovering at the target by default).
+// Points are stored row-major over `Axes`, the last axis varying fastest.
+struct PolicyField {
+    std::vector<PolicyAxisRange> Axes;
+    DroneState Base {};
+    std::vector<std::array<FP, OutputSize>> Thrust;
+
+    size_t PointCount() const;
+
+    // State of point `index`, and its per-axis step indices in `steps` (one per axis).
+    DroneState PointState(size_t index, int* steps = nullptr) const;
+
+    // Fills `Thrust` with `net` evaluated on every point. Chunks of points are generated and evaluated
+    // as batches on `pool`, each written straight into its slice of `Thrust`.
+    void Evaluate(const ControlNetwork& net, ll::ThreadPool& pool);
+
+    // One row per point with the swept values followed by the outputs.
+    bool WriteCsv(const char* fileName) const;
+
+    // Header ("SCPF", version, `sizeof(FP)`, axis count, then axis id, min, max and steps per axis),
+    // followed by point count and the outputs as `FP` in point order. Integers are 32 bit except the count, limits are doubles.
+    bool WriteBinary(const char* fileName) const;
+};
@@ -0,0 +1,186 @@
+#include "QuantizedNetwork.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr FP MinQuantRange = 1e-6;
+
+// Leaky ReLU slope of 0.1 as a Q15 multiplier.
+static constexpr int32_t LeakySlopeQ15 = 3277;
+
+// Computes both sides and selects, so the loops over a layer vectorize instead of branching on every sign.
+static int32_t FixedLeakyReLU(int32_t x) {
+    auto negative = (int32_t) (((int64_t) x * LeakySlopeQ15 + (1 << 14)) >> 15);
+    return x < 0 ? negative : x;
+}
+
+static int8_t SaturateInt8(int32_t x) {
+    return (int8_t) std::clamp(x, -127, 127);
+}
+
+static constexpr FP ActivationSteps = 32767.0;
+
+static int16_t SaturateInt16(int32_t x) {
+    return (int16_t) std::clamp(x, -32767, 32767);
+}
+
+// Round half away from zero, without going through libm. Out-of-range values saturate and NaN becomes zero, since
+// converting either to `int32_t` is undefined.
+static int32_t RoundToInt(FP x) {
+    constexpr FP limit = std::numeric_limits<int32_t>::max();
+    if (std::isnan(x)) return 0;
+    x = std::clamp(x, -limit, limit);
+    return (int32_t) (x + (x < 0.0 ? -0.5 : 0.5));
+}
+
+// `SaturateInt16(RoundToInt(x))` without branches. Clamping to the int16 range before rounding gives the same steps.
+static int16_t QuantizeActivation(FP x) {
+    FP clamped = std::min(std::max(x == x ? x : 0.0, -ActivationSteps), ActivationSteps);
+    return (int16_t) (clamped + std::copysign(0.5, clamped));
+}
+
+template <size_t N>
+static void RequantizeLayer(const std::array<int32_t, N>& acc, QuantizedNetwork::FixedPointScale scale, std::array<int16_t, N>& out) {
+    for (size_t i = 0; i < N; i++) out[i] = SaturateInt16(scale.Apply(FixedLeakyReLU(acc[i])));
+}
+
+static FP FloatLeakyReLU(FP x) {
+    return LeakyReLUActivation::Apply(x);
+}
+
+QuantizedNetwork::FixedPointScale QuantizedNetwork::FixedPointScale::FromReal(double value) {
+    int exponent = 0;
+    double normalized = std::frexp(value, &exponent);
+
+    auto multiplier = (int64_t) std::llround(normalized * (int64_t(1) << 31));
+    if (multiplier == (int64_t(1) << 31)) {
+        multiplier /= 2;
+        exponent++;
+    }
+
+    FixedPointScale scale;
+    scale.Multiplier = (int32_t) multiplier;
+    scale.Shift = std::clamp(31 - exponent, 1, 62);
+    return scale;
+}
+
+QuantizedNetwork::Calibration QuantizedNetwork::Calibrate(const ControlNetwork& net, const std::vector<std::array<FP, InputSize>>& inputs) {
+    Calibration calibration;
+    calibration.InputRange.fill(MinQuantRange);
+    calibration.Hidden1Range = MinQuantRange;
+    calibration.Hidden2Range = MinQuantRange;
+
+    for (auto& input : inputs) {
+        for (int j = 0; j < (int) InputSize; j++) {
+            calibration.InputRange[j] = std::max(calibration.InputRange[j], std::abs(input[j]));
+        }
+
+        std::array<FP, Hidden1Size> h1;
+        for (int i = 0; i < (int) Hidden1Size; i++) {
+            FP sum = 0;
+            for (int j = 0; j < (int) InputSize; j++) {
+                sum += input[j] * net.InToH1Weights()[i][j] + net.H1Biases()[i];
+            }
+            h1[i] = FloatLeakyReLU(sum);
+            calibration.Hidden1Range = std::max(calibration.Hidden1Range, std::abs(h1[i]));
+        }
+
+        for (int i = 0; i < (int) Hidden2Size; i++) {
+            FP sum = 0;
+            for (int j = 0; j < (int) Hidden1Size; j++) {
+                sum += h1[j] * net.H1ToH2Weights()[i][j] + net.H2Biases()[i];
+            }
+            calibration.Hidden2Range = std::max(calibration.Hidden2Range, std::abs(FloatLeakyReLU(sum)));
+        }
+    }
+
+    return calibration;
+}
+
+// Symmetric per-layer quantization of a weight matrix, transposed. Returns the real value of one int8 step.
+template <size_t Rows, size_t Cols, size_t PaddedRows>
+static FP QuantizeLayer(const MatrixView<const FP>& weights, std::array<std::array<int8_t, PaddedRows>, Cols>& out) {
+    FP maxAbs = MinQuantRange;
+    for (size_t i = 0; i < Rows; i++) {
+        for (size_t j = 0; j < Cols; j++) maxAbs = std::max(maxAbs, std::abs(weights[i][j]));
+    }
+
+    FP scale = maxAbs / 127.0;
+    for (size_t i = 0; i < Rows; i++) {
+        for (size_t j = 0; j < Cols; j++) {
+            out[j][i] = SaturateInt8(RoundToInt(weights[i][j] / scale));
+        }
+    }
+    return scale;
+}
+
+// Integer sums are exact, so the order across neurons gives the same accumulators as one dot product per neuron.
+template <size_t Rows, size_t Cols>
+void QuantizedNetwork::Layer<Rows, Cols>::Accumulate(const int16_t* x, int32_t* acc) const {
+    for (size_t i = 0; i < Padded<Rows>; i++) acc[i] = Biases[i];
+    for (size_t j = 0; j < Cols; j++) {
+        int32_t xj = x[j];
+        for (size_t i = 0; i < Padded<Rows>; i++) acc[i] += xj * Weights[j][i];
+    }
+}
+
+QuantizedNetwork::QuantizedNetwork(const ControlNetwork& net, const Calibration& calibration) {
+    // Input scales are folded into the first layer, so the fixed-point input of feature `j` is `x[j] / inputScale[j]`.
+    std::array<FP, InputSize> inputScales;
+    for (int j = 0; j < (int) InputSize; j++) {
+        inputScales[j] = calibration.InputRange[j] / ActivationSteps;
+        InputInvScales[j] = 1.0 / inputScales[j];
+    }
+
+    std::array<FP, Hidden1Size * InputSize> foldedInWeights;
+    for (int i = 0; i < (int) Hidden1Size; i++) {
+        for (int j = 0; j < (int) InputSize; j++) foldedInWeights[i * InputSize + j] = net.InToH1Weights()[i][j] * inputScales[j];
+    }
+
+    FP h1Scale = calibration.Hidden1Range / ActivationSteps;
+    FP h2Scale = calibration.Hidden2Range / ActivationSteps;
+
+    FP w1Scale = QuantizeLayer<Hidden1Size>(MatrixView<const FP> {foldedInWeights.data(), Hidden1Size, InputSize}, InToH1.Weights);
+    FP w2Scale = QuantizeLayer<Hidden2Size>(net.H1ToH2Weights(), H1ToH2.Weights);
+    FP w3Scale = QuantizeLayer<OutputSize>(net.H2ToOutWeights(), H2ToOut.Weights);
+
+    // `EvaluateNetwork` adds the bias once per incoming connection, so the effective bias is scaled by the fan-in.
+    FP acc1Scale = w1Scale;
+    FP acc2Scale = h1Scale * w2Scale;
+    FP acc3Scale = h2Scale * w3Scale;
+
+    for (int i = 0; i < (int) Hidden1Size; i++) InToH1.Biases[i] = RoundToInt(net.H1Biases()[i] * InputSize / acc1Scale);
+    for (int i = 0; i < (int) Hidden2Size; i++) H1ToH2.Biases[i] = RoundToInt(net.H2Biases()[i] * Hidden1Size / acc2Scale);
+    for (int i = 0; i < (int) OutputSize; i++) H2ToOut.Biases[i] = RoundToInt(net.OutBiases()[i] * Hidden2Size / acc3Scale);
+
+    H1Requantize = FixedPointScale::FromReal(acc1Scale / h1Scale);
+    H2Requantize = FixedPointScale::FromReal(acc2Scale / h2Scale);
+    OutScale = acc3Scale;
+}
+
+std::array<FP, OutputSize> QuantizedNetwork::EvaluateNetwork(const std::array<FP, InputSize>& input) const {
+    std::array<int16_t, InputSize> qInput;
+    for (int j = 0; j < (int) InputSize; j++) qInput[j] = QuantizeActivation(input[j] * InputInvScales[j]);
+
+    alignas(SimdBytes) std::array<int32_t, Padded<Hidden1Size>> acc1;
+    InToH1.Accumulate(qInput.data(), acc1.data());
+
+    std::array<int16_t, Padded<Hidden1Size>> h1;
+    RequantizeLayer(acc1, H1Requantize, h1);
+
+    alignas(SimdBytes) std::array<int32_t, Padded<Hidden2Size>> acc2;
+    H1ToH2.Accumulate(h1.data(), acc2.data());
+
+    std::array<int16_t, Padded<Hidden2Size>> h2;
+    RequantizeLayer(acc2, H2Requantize, h2);
+
+    alignas(SimdBytes) std::array<int32_t, Padded<OutputSize>> acc3;
+    H2ToOut.Accumulate(h2.data(), acc3.data());
+
+    std::array<FP, OutputSize> out;
+    for (int i = 0; i < (int) OutputSize; i++) out[i] = FixedLeakyReLU(acc3[i]) * OutScale;
+
+    return out;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Config.hpp"
+#include "ControlNetwork.hpp"
+
+// Int8 inference path for a trained `ControlNetwork`.
+// Weights are symmetric int8 with one scale per layer, activations are int16 fixed-point with one scale per layer
+// (taken from calibration), accumulation is done in int32 and requantization uses fixed-point multipliers.
+// Inputs are quantized per feature, and those scales are folded into the first layer weights.
+// Weights are stored transposed and padded to whole int32 vectors, so each input is multiplied into the accumulators of
+// every neuron of the layer at once, like the float `DenseLayer`.
+class QuantizedNetwork {
+    public:
+        // Real multiplier stored as `Multiplier * 2^-Shift`, with `Multiplier` normalized to 31 bits.
+        struct FixedPointScale {
+            int32_t Multiplier = 0;
+            int Shift = 0;
+
+            static FixedPointScale FromReal(double value);
+
+            int32_t Apply(int32_t value) const {
+                int64_t product = (int64_t) value * Multiplier;
+                return (int32_t) ((product + (int64_t(1) << (Shift - 1))) >> Shift);
+            }
+        };
+
+        // Largest absolute value seen on each network input and hidden layer output.
+        struct Calibration {
+            std::array<FP, InputSize> InputRange;
+            FP Hidden1Range = 0.0;
+            FP Hidden2Range = 0.0;
+        };
+
+        // Runs the float network over recorded inputs (see `PhysicsSim::InputLog`) and records activation ranges.
+        // The fixed-point path implements the leaky ReLU only.
+        static constexpr bool Supported() { return ControlNetwork::ActivationType::Kind == ActivationKind::LeakyReLU; }
+
+        static Calibration Calibrate(const ControlNetwork& net, const std::vector<std::array<FP, InputSize>>& inputs);
+
+        QuantizedNetwork(const ControlNetwork& net, const Calibration& calibration);
+
+        std::array<FP, OutputSize> EvaluateNetwork(const std::array<FP, InputSize>& input) const;
+
+    private:
+        static constexpr size_t Lanes = SimdBytes / sizeof(int32_t);
+
+        template <size_t Rows>
+        static constexpr size_t Padded = (Rows + Lanes - 1) / Lanes * Lanes;
+
+        // `Weights[j][i]` connects input `j` to neuron `i`; padding neurons have zero weights and biases.
+        template <size_t Rows, size_t Cols>
+        struct Layer {
+            alignas(SimdBytes) std::array<std::array<int8_t, Padded<Rows>>, Cols> Weights {};
+            alignas(SimdBytes) std::array<int32_t, Padded<Rows>> Biases {};
+
+            void Accumulate(const int16_t* x, int32_t* acc) const;
+        };
+
+        Layer<Hidden1Size, InputSize> InToH1;
+        Layer<Hidden2Size, Hidden1Size> H1ToH2;
+        Layer<OutputSize, Hidden2Size> H2ToOut;
+
+        std::array<FP, InputSize> InputInvScales;
+        FixedPointScale H1Requantize;
+        FixedPointScale H2Requantize;
+        FP OutScale;
+};
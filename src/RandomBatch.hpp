@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <span>
+
+#include "Simd.hpp"
+#include "VectorMath.hpp"
+
+// Whole buffers of random bits, uniforms and normals from a 64-bit URBG. Generators with a `Fill` member
+// (`CounterRng`) produce the bits a vector of blocks at a time; the results are the same as drawing one by one.
+
+// Values converted per pass; keeps the bits on the stack (2 KiB).
+constexpr size_t RandomBatchChunk = 256;
+
+template <class G>
+void FillRandomBits(G& gen, std::span<uint64_t> out) {
+    static_assert(sizeof(typename G::result_type) == 8, "FillRandomBits needs 64 random bits per draw");
+
+    if constexpr (requires { gen.Fill(out); }) gen.Fill(out);
+    else for (auto& w : out) w = gen();
+}
+
+// Uniform in [a, b) with 53 random bits per value, like `CounterRng::UniformFP`.
+template <class G>
+void FillUniform(G& gen, std::span<FP> out, FP a, FP b) {
+    alignas(SimdBytes) uint64_t bits[RandomBatchChunk];
+
+    for (size_t first = 0; first < out.size(); first += RandomBatchChunk) {
+        size_t n = std::min(RandomBatchChunk, out.size() - first);
+        FillRandomBits(gen, std::span(bits, n));
+
+        size_t i = 0;
+        for (; i + SimdWidth <= n; i += SimdWidth) {
+            IntVec w;
+            std::memcpy(&w, bits + i, sizeof(w));
+            FPVec u = __builtin_convertvector((w >> 11) & 0x1fffffffffffff, FPVec) * 0x1p-53;
+            SimdStore(out.data() + first + i, a + u * (b - a));
+        }
+        for (; i < n; i++) out[first + i] = a + (bits[i] >> 11) * 0x1p-53 * (b - a);
+    }
+}
+
+// N(0, sigma) by Box-Muller on whole vectors: each pair of vectors of bits gives a vector of cosines and one of sines.
+// Draws a multiple of `2 * SimdWidth` values, so a short tail still uses the vector path.
+template <class G>
+void FillNormal(G& gen, std::span<FP> out, FP sigma) {
+    alignas(SimdBytes) uint64_t bits[RandomBatchChunk];
+    static_assert(RandomBatchChunk % (2 * SimdWidth) == 0);
+
+    for (size_t first = 0; first < out.size(); first += RandomBatchChunk) {
+        size_t n = std::min(RandomBatchChunk, out.size() - first);
+        size_t drawn = (n + 2 * SimdWidth - 1) / (2 * SimdWidth) * (2 * SimdWidth);
+        FillRandomBits(gen, std::span(bits, drawn));
+
+        for (size_t i = 0; i < drawn; i += 2 * SimdWidth) {
+            IntVec w1, w2;
+            std::memcpy(&w1, bits + i, sizeof(w1));
+            std::memcpy(&w2, bits + i + SimdWidth, sizeof(w2));
+
+            // The first uniform in (0, 1] so the logarithm is finite.
+            FPVec u1 = __builtin_convertvector(((w1 >> 11) & 0x1fffffffffffff) + 1, FPVec) * 0x1p-53;
+            FPVec angle = __builtin_convertvector((w2 >> 11) & 0x1fffffffffffff, FPVec) * (0x1p-53 * 2.0 * std::numbers::pi);
+
+            FPVec radius = sigma * VectorSqrt(-2.0 * VectorLog(u1));
+            FPVec s, c;
+            VectorSinCos(angle, s, c);
+
+            FPVec values[2] = {radius * c, radius * s};
+            size_t count = std::min<size_t>(2 * SimdWidth, n - std::min(n, i));
+            std::memcpy(out.data() + first + i, values, count * sizeof(FP));
+        }
+    }
+}
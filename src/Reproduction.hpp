@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <utility>
+
+#include "Config.hpp"
+#include "RandomBatch.hpp"
+#include "Simd.hpp"
+#include "VectorMath.hpp"
+
+// Genetic operators over flat genome spans. Children are written straight into their destination buffer,
+// so reproducing a population needs no temporaries and no zeroed networks.
+
+struct ReproductionParams {
+    CrossoverKind Crossover = CrossoverKind::Average;
+    FP MutationRate = 0.0;          // Standard deviation of the Gaussian added to mutated genes.
+    size_t MutatedGenes = 1;        // Genes mutated per child, drawn with replacement. The whole genome from its size up.
+};
+
+// `child = (a + b) / 2`.
+inline void AverageCrossover(std::span<FP> child, std::span<const FP> a, std::span<const FP> b) {
+    size_t n = child.size();
+    size_t i = 0;
+
+    FPVec half = SimdBroadcast(0.5);
+    for (; i + SimdWidth <= n; i += SimdWidth) {
+        SimdStore(child.data() + i, (SimdLoad(a.data() + i) + SimdLoad(b.data() + i)) * half);
+    }
+    for (; i < n; i++) child[i] = (a[i] + b[i]) / 2;
+}
+
+// Each gene from `a` or `b` with equal probability, one random word per 64 genes.
+template <class G>
+void UniformCrossover(std::span<FP> child, std::span<const FP> a, std::span<const FP> b, G& gen) {
+    static_assert(sizeof(typename G::result_type) == 8, "UniformCrossover needs 64 random bits per draw");
+
+    size_t n = child.size();
+    for (size_t block = 0; block < n; block += 64) {
+        uint64_t bits = gen();
+        size_t end = std::min(n, block + 64);
+
+        for (size_t i = block; i < end; i++) {
+            child[i] = (bits >> (i - block)) & 1 ? a[i] : b[i];
+        }
+    }
+}
+
+// Pair of independent N(0, sigma) draws (Box-Muller).
+template <class G>
+std::pair<FP, FP> GaussianPair(FP sigma, G& gen) {
+    static_assert(sizeof(typename G::result_type) == 8, "GaussianPair needs 64 random bits per draw");
+
+    // 53-bit uniforms, the first in (0, 1] so the logarithm is finite.
+    FP u1 = ((gen() >> 11) + 1) * 0x1p-53;
+    FP u2 = (gen() >> 11) * 0x1p-53;
+
+    FP radius = sigma * std::sqrt(-2.0 * std::log(u1));
+    FP angle = 2.0 * std::numbers::pi * u2;
+    return {radius * std::cos(angle), radius * std::sin(angle)};
+}
+
+// Adds N(0, sigma) to every value of `out`.
+template <class G>
+void AddGaussian(std::span<FP> out, FP sigma, G& gen) {
+    alignas(SimdBytes) FP noise[RandomBatchChunk];
+
+    for (size_t first = 0; first < out.size(); first += RandomBatchChunk) {
+        size_t n = std::min(RandomBatchChunk, out.size() - first);
+        FillNormal(gen, std::span(noise, n), sigma);
+
+        for (size_t i = 0; i < n; i++) out[first + i] += noise[i];
+    }
+}
+
+// Adds N(0, sigma) to `count` genes picked uniformly with replacement, or to all of them when `count >= out.size()`.
+template <class G>
+void MutateGenes(std::span<FP> out, FP sigma, size_t count, G& gen) {
+    size_t n = out.size();
+    if (count >= n) {
+        AddGaussian(out, sigma, gen);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i += 2) {
+        auto [x, y] = GaussianPair(sigma, gen);
+        out[gen() % n] += x;
+        if (i + 1 < count) out[gen() % n] += y;
+    }
+}
+
+// Crossover of `a` and `b` into `child`, then mutation. `child` must not overlap the parents.
+template <class G>
+void Reproduce(std::span<FP> child, std::span<const FP> a, std::span<const FP> b, const ReproductionParams& params, G& gen) {
+    switch (params.Crossover) {
+        case CrossoverKind::Average:
+            AverageCrossover(child, a, b);
+            break;
+        case CrossoverKind::Uniform:
+            UniformCrossover(child, a, b, gen);
+            break;
+    }
+
+    if (params.MutationRate > 0.0) MutateGenes(child, params.MutationRate, params.MutatedGenes, gen);
+}
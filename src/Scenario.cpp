@@ -0,0 +1,46 @@
+#include "Scenario.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+
+Scenario::Scenario(const Vec2& target) : Target(target) {
+    TimeLimit = target.Mag() / PhysicsSimTargetDroneSpeed + 1.5;
+}
+
+std::vector<Scenario> GenerateScenarios(int count, uint32_t seed) {
+    std::mt19937 gen {seed};
+    std::uniform_real_distribution<FP> coord {-TrainingMaxCoords, TrainingMaxCoords};
+
+    std::vector<Scenario> scenarios;
+    scenarios.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        auto x = coord(gen);
+        auto y = coord(gen);
+        scenarios.emplace_back(Vec2 {x, y});
+    }
+    return scenarios;
+}
+
+DroneState TrainingInitialState(const RngKey& key, int episode) {
+    DroneState state;
+    if constexpr (TrainingUseRandomInitConditions) {
+        CounterRng rng(key, RngStream::InitialState, episode);
+        state.AngularVelocity = rng.UniformFP(-1, 1);
+        state.Velocity.x = rng.UniformFP(-1, 1);
+        state.Velocity.y = rng.UniformFP(-1, 1);
+        state.DirectionAngle = rng.UniformFP(-1, 1);
+    }
+    return state;
+}
+
+FP ScenarioPenalty(const DroneState& drone, const Vec2& target) {
+    FP penalty = (drone.Position - target).Mag2() * TrainingDistancePenaltyWeight;
+    penalty += drone.Velocity.Mag() * TrainingSpeedPenaltyWeight;
+    penalty += std::abs(std::min(drone.DirectionAngle, 2 * std::numbers::pi - drone.DirectionAngle) * TrainingAnglePenaltyWeight);
+    penalty += std::abs(drone.AngularVelocity) * TrainingAngularVelPenaltyWeight;
+    return penalty;
+}
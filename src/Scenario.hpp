@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CounterRng.hpp"
+#include "Drone.hpp"
+#include "PhysicsSim.hpp"
+#include "Vec2.hpp"
+
+// A single training-style flight: start at rest on the origin and reach `Target` before `TimeLimit`.
+struct Scenario {
+    Vec2 Target;
+    FP TimeLimit;
+
+    Scenario(const Vec2& target);
+};
+
+struct FlightResult {
+    FP Penalty = 0.0;
+    int Steps = 0;
+    std::vector<Vec2> Trajectory;
+};
+
+// State training episode `episode` of the drone keyed by `key` starts in: at rest on the origin, or with
+// `TrainingUseRandomInitConditions` a random velocity, spin and heading drawn from its `RngStream::InitialState`.
+DroneState TrainingInitialState(const RngKey& key, int episode);
+
+// Builds a reproducible set of scenarios with the same target distribution used for training.
+std::vector<Scenario> GenerateScenarios(int count, uint32_t seed);
+
+// Penalty for a finished flight, using the training weights from `Config.hpp`.
+FP ScenarioPenalty(const DroneState& drone, const Vec2& target);
+
+// Flies `drone` through `scenario` using `controller(inputs)` for thrust.
+// Use `recordTrajectory` to keep the position at every step.
+template <class C>
+FlightResult FlyScenario(Drone& drone, const Scenario& scenario, const C& controller, bool recordTrajectory = false, std::vector<std::array<FP, InputSize>>* inputLog = nullptr) {
+    PhysicsSim sim(drone);
+    sim.InputLog = inputLog;
+
+    FlightResult result;
+
+    for (FP t = 0.0; t < scenario.TimeLimit; t += PhysicsSimDeltaT) {
+        sim.ControllerStep(controller, scenario.Target, PhysicsSimDeltaT);
+        sim.DoSimulationStep(PhysicsSimDeltaT);
+
+        if (recordTrajectory) result.Trajectory.push_back(drone.Position);
+        result.Steps++;
+    }
+
+    result.Penalty = ScenarioPenalty(drone, scenario.Target);
+    return result;
+}
+
+// Flies `drone` through `scenario` with its own brain.
+inline FlightResult FlyScenario(Drone& drone, const Scenario& scenario, bool recordTrajectory = false, std::vector<std::array<FP, InputSize>>* inputLog = nullptr) {
+    return FlyScenario(drone, scenario, [&drone] (const std::array<FP, InputSize>& input) {
+        return drone.Brain.EvaluateNetwork(input);
+    }, recordTrajectory, inputLog);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "FPType.hpp"
+
+// Native vector width in `FP` lanes for the target the project is compiled for (`-march=native`).
+#if defined(__AVX512F__)
+constexpr int SimdBytes = 64;
+#elif defined(__AVX__)
+constexpr int SimdBytes = 32;
+#else
+constexpr int SimdBytes = 16;
+#endif
+
+constexpr int SimdWidth = SimdBytes / sizeof(FP);
+
+// Native vector of `FP` (GCC/Clang vector extension), supports the usual arithmetic operators lane-wise.
+using FPVec = FP __attribute__((vector_size(SimdBytes)));
+
+inline FPVec SimdLoad(const FP* ptr) {
+    FPVec v;
+    std::memcpy(&v, ptr, sizeof(FPVec));
+    return v;
+}
+
+inline void SimdStore(FP* ptr, const FPVec& v) {
+    std::memcpy(ptr, &v, sizeof(FPVec));
+}
+
+inline FPVec SimdBroadcast(FP value) {
+    return FPVec {} + value;
+}
+
+inline FP SimdSum(const FPVec& v) {
+    FP sum = 0.0;
+    for (int i = 0; i < SimdWidth; i++) sum += v[i];
+    return sum;
+}
+
+// Allocator returning memory aligned to the vector size, so heap buffers can be used with aligned vector loads.
+template <class T>
+struct SimdAllocator {
+    using value_type = T;
+
+    SimdAllocator() = default;
+
+    template <class U>
+    SimdAllocator(const SimdAllocator<U>&) { }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(SimdBytes)));
+    }
+
+    void deallocate(T* ptr, size_t) {
+        ::operator delete(ptr, std::align_val_t(SimdBytes));
+    }
+
+    // Default-initializes instead of value-initializing, so `resize` leaves new values unwritten: every buffer
+    // using this allocator is filled before it is read, and zeroing first would only double the memory traffic.
+    template <class U, class... Args>
+    void construct(U* ptr, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) ::new ((void*) ptr) U;
+        else ::new ((void*) ptr) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    bool operator ==(const SimdAllocator<U>&) const { return true; }
+};
@@ -1,56 +1,202 @@
 #include "TrainingSim.hpp"
 #include "Config.hpp"
 #include "ControlNetwork.hpp"
+#include "DifferentiableSim.hpp"
 #include "Drone.hpp"
 #include "PhysicsSim.hpp"
+#include "Scenario.hpp"
 #include "Util.hpp"
 
 #include <ThreadPool.hpp>
 
 #include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <iostream>
 #include <random>
 #include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+static ll::Placement TrainingPlacement() {
+    switch (TrainingThreadPinning) {
+        case ThreadPinning::Compact:
+            return {ll::PinPolicy::Compact};
+        case ThreadPinning::Scatter:
+            return {ll::PinPolicy::Scatter};
+        default:
+            return {};
+    }
+}
+
+static ll::ThreadPool pool {SimulationThreads, ll::Scheduler::SharedQueue, TrainingPlacement()};
+
+ll::ThreadPool& TrainingSim::GetPool() {
+    return pool;
+}
+
+TrainingSim::TrainingSim(uint64_t seed) : Seed(seed) {
+    // One slice per worker, built and randomized by that worker, so genome buffers are allocated and first written in
+    // parallel. Every drone draws from its own stream, so the genomes do not depend on the split. `TrainGeneration` hands
+    // drones to any free worker and sorts them every generation, so this is not a NUMA placement.
+    std::vector<std::vector<Drone>> slices(SimulationThreads);
+
+    pool.RunOnEachWorker([this, &slices] (int t) {
+        int first = t * GenerationSize / SimulationThreads;
+        int last = (t + 1) * GenerationSize / SimulationThreads;
+
+        auto& slice = slices[t];
+        slice.reserve(last - first);
+        for (int i = first; i < last; i++) {
+            slice.emplace_back(ControlNetwork(ControlNetwork::InitMode::Uninitialized));
+
+            CounterRng rng({Seed, 0, (uint32_t) i}, RngStream::Initialization);
+            slice.back().Brain.Randomize(rng);
+        }
+    });
 
-TrainingSim::TrainingSim() {
     Drones.reserve(GenerationSize);
+    for (auto& slice : slices) std::move(slice.begin(), slice.end(), std::back_inserter(Drones));
+}
 
-    for (int i = 0; i < (int) GenerationSize; i++) {
-        Drones.emplace_back();
-    }
+std::future<TrainingSim> TrainingSim::CreateAsync(uint64_t seed) {
+    return std::async(std::launch::async, [seed] { return TrainingSim(seed); });
 }
 
-FP TrainingSim::DoDronePerformanceSimulation(Drone& drone) {
-    PhysicsSim sim(drone);
+static constexpr int EpisodeLanes = std::min(TrainingEpisodeLanes, SimulationsPerDrone);
+
+// Runs every scenario in lockstep batches of `EpisodeLanes` and returns the average penalty.
+// Each control step evaluates the network once for all running episodes through
+// `controller(inputs, outputs, count)`, which turns the per-episode GEMVs into one small GEMM,
+// then advances each episode by up to `TrainingControlInterval` physics steps with that thrust request.
+template <class C>
+static FP RunTrainingEpisodes(const std::vector<Scenario>& scenarios, const C& controller, const RngKey& key, EpisodeLaneStats& laneStats) {
+    std::array<std::conditional_t<TrainingUsesHeadingStep, HeadingDroneState, DroneState>, SimulationsPerDrone> states;
+    std::array<std::array<FP, 2>, SimulationsPerDrone> thrust {};
+    std::array<int, SimulationsPerDrone> stepsLeft;
+
+    // Episodes waiting for a lane, longest first, so the batch drains evenly at the end.
+    std::array<int, SimulationsPerDrone> queue;
+    int numQueued = 0;
+    int nextQueued = 0;
+
+    // Indices of the episodes in the lanes, kept compacted at the front.
+    std::array<int, EpisodeLanes> running;
+    int numRunning = 0;
+
+    FP inputs[EpisodeLanes * InputSize];
+    FP outputs[EpisodeLanes * OutputSize];
+
+    for (int e = 0; e < (int) SimulationsPerDrone; e++) {
+        if constexpr (TrainingUsesHeadingStep) {
+            states[e] = HeadingDroneState(TrainingInitialState(key, e));
+        }
+        else {
+            states[e] = TrainingInitialState(key, e);
+        }
+
+        stepsLeft[e] = 0;
+        for (FP t = 0.0; t < scenarios[e].TimeLimit; t += TrainingDeltaT) stepsLeft[e]++;
 
-    FP penaltyScore = 0.0;
-    for (int i = 0; i < (int) SimulationsPerDrone; i++) {
-        sim.Reset();
-        Vec2 target {RandomFP(-TrainingMaxCoords, TrainingMaxCoords), RandomFP(-TrainingMaxCoords, TrainingMaxCoords)};
-        //Vec2 target;
+        if (stepsLeft[e] > 0) queue[numQueued++] = e;
+    }
+
+    std::stable_sort(queue.begin(), queue.begin() + numQueued, [&] (int a, int b) {
+        return stepsLeft[a] > stepsLeft[b];
+    });
+
+    while (numRunning < EpisodeLanes && nextQueued < numQueued) running[numRunning++] = queue[nextQueued++];
 
-        FP timeLimit = target.Mag() / PhysicsSimTargetDroneSpeed + 1.5;
+    while (numRunning > 0) {
+        laneStats.UsedLanes += numRunning;
+        laneStats.TotalLanes += EpisodeLanes;
 
-        if constexpr (TrainingUseRandomInitConditions) {
-            drone.AngularVelocity = RandomFP(-1, 1);
-            drone.Velocity.x = RandomFP(-1, 1);
-            drone.Velocity.y = RandomFP(-1, 1);
-            drone.DirectionAngle = RandomFP(-1, 1);
+        for (int r = 0; r < numRunning; r++) {
+            int e = running[r];
+            auto input = PhysicsSim::NetworkInputs(states[e], scenarios[e].Target);
+            std::copy(input.begin(), input.end(), inputs + r * InputSize);
         }
 
-        for (FP t = 0.0; t < timeLimit; t += PhysicsSimDeltaT) {
-            sim.NetworkControlStep(target, PhysicsSimDeltaT);
-            sim.DoSimulationStep(PhysicsSimDeltaT);
+        controller(inputs, outputs, numRunning);
+
+        int kept = 0;
+        for (int r = 0; r < numRunning; r++) {
+            int e = running[r];
+            FP left = outputs[r * OutputSize];
+            FP right = outputs[r * OutputSize + 1];
+
+            int steps = std::min<int>(TrainingControlInterval, stepsLeft[e]);
+            for (int s = 0; s < steps; s++) {
+                if constexpr (TrainingUsesHeadingStep) {
+                    PhysicsSim::HeadingStep(states[e], thrust[e], left, right, TrainingDeltaT);
+                }
+                else {
+                    PhysicsSim::UpdateThrust(thrust[e], left, right, TrainingDeltaT);
+                    PhysicsSim::IntegrateState(states[e], thrust[e], TrainingDeltaT, TrainingIntegrator);
+                }
+            }
+
+            stepsLeft[e] -= steps;
+            if (stepsLeft[e] > 0) running[kept++] = e;
         }
 
-        FP simPenaltyScore = (sim.SimDrone->Position - target).Mag2() * TrainingDistancePenaltyWeight;
-        simPenaltyScore += sim.SimDrone->Velocity.Mag() * TrainingSpeedPenaltyWeight;
-        simPenaltyScore += std::abs(std::min(sim.SimDrone->DirectionAngle, 2 * std::numbers::pi - sim.SimDrone->DirectionAngle) * TrainingAnglePenaltyWeight);
-        simPenaltyScore += std::abs(sim.SimDrone->AngularVelocity) * TrainingAngularVelPenaltyWeight;
+        while (kept < EpisodeLanes && nextQueued < numQueued) running[kept++] = queue[nextQueued++];
+        numRunning = kept;
+    }
+
+    FP penaltyScore = 0.0;
+    for (int e = 0; e < (int) SimulationsPerDrone; e++) {
+        FP simPenaltyScore = ScenarioPenalty(states[e], scenarios[e].Target);
 
         penaltyScore += simPenaltyScore / SimulationsPerDrone;
     }
+    return penaltyScore;
+}
+
+static bool ShouldCompileBrain(const Drone& drone, FP expectedEvaluations) {
+    if (drone.CompiledBrain) return false;
+
+    switch (TrainingJitPolicy) {
+        case JitPolicy::Never:
+            return false;
+        case JitPolicy::Always:
+            return true;
+        case JitPolicy::Auto:
+            return NetworkJit::GetCostModel().PaysOff(expectedEvaluations);
+    }
+    return false;
+}
+
+FP TrainingSim::DoDronePerformanceSimulation(Drone& drone, int index, EpisodeLaneStats& laneStats) {
+    RngKey key {Seed, (uint32_t) GenerationsDone, (uint32_t) index};
+
+    std::vector<Scenario> scenarios;
+    scenarios.reserve(SimulationsPerDrone);
+
+    FP expectedEvaluations = 0.0;
+    for (int i = 0; i < (int) SimulationsPerDrone; i++) {
+        CounterRng rng(key, RngStream::Scenarios, i);
+        scenarios.push_back({{rng.UniformFP(-TrainingMaxCoords, TrainingMaxCoords), rng.UniformFP(-TrainingMaxCoords, TrainingMaxCoords)}});
+        expectedEvaluations += std::ceil(scenarios.back().TimeLimit / (TrainingDeltaT * TrainingControlInterval));
+    }
+
+    if (ShouldCompileBrain(drone, expectedEvaluations)) {
+        drone.CompiledBrain = NetworkJit::Compile(drone.Brain);
+    }
+
+    FP penaltyScore = 0.0;
+
+    if (drone.CompiledBrain) {
+        penaltyScore = RunTrainingEpisodes(scenarios, [jit = drone.CompiledBrain.get()] (const FP* inputs, FP* outputs, int count) {
+            jit->EvaluateNetworkBatch(inputs, outputs, count);
+        }, key, laneStats);
+    }
+    else {
+        penaltyScore = RunTrainingEpisodes(scenarios, [&drone] (const FP* inputs, FP* outputs, int count) {
+            drone.Brain.EvaluateNetworkBatch(inputs, outputs, count);
+        }, key, laneStats);
+    }
 
     //penaltyScore += drone.Brain.GetAbsoluteNetworkWeight() * TrainingNetworkWeightPenalty;
 
@@ -58,31 +204,51 @@ FP TrainingSim::DoDronePerformanceSimulation(Drone& drone) {
     return penaltyScore;
 }
 
-static ll::ThreadPool pool {SimulationThreads};
-
-FP TrainingSim::TrainGeneration() {
-    std::atomic<FP> avgPenalty = 0;
-
-    auto dronesPerThread = GenerationSize / SimulationThreads;
+FP TrainingSim::EpisodePenalty(const ControlNetwork& net, const std::vector<Scenario>& scenarios, const RngKey& key) {
+    EpisodeLaneStats laneStats;
+    return RunTrainingEpisodes(scenarios, [&net] (const FP* inputs, FP* outputs, int count) {
+        net.EvaluateNetworkBatch(inputs, outputs, count);
+    }, key, laneStats);
+}
 
-    static auto worker = [this, &avgPenalty] (int numDrones, int startIndex) {
-        for (int i = startIndex; i < startIndex + numDrones; i++) {
-            avgPenalty += DoDronePerformanceSimulation(Drones[i]);
-        }
-    };
+// Per-drone results summed over the population.
+struct GenerationTotals {
+    FP Penalty = 0.0;
+    EpisodeLaneStats Lanes;
+};
 
-    for (int i = 0; i < (int) SimulationThreads; i++) {
-        pool.Submit(worker, dronesPerThread, i * dronesPerThread);
+FP TrainingSim::TrainGeneration() {
+    if constexpr (TrainingJitPolicy == JitPolicy::Auto) {
+        NetworkJit::GetCostModel();
     }
-    pool.WaitUntilEmpty();
 
-    avgPenalty = avgPenalty / GenerationSize;
+    // Drones cost more or less depending on their episodes and on being JIT-compiled, so chunks are handed out as they finish.
+    // The totals are combined in population order, so they do not depend on which thread finished first.
+    auto totals = pool.TransformReduce(0, GenerationSize, 1, GenerationTotals {}, [] (GenerationTotals a, const GenerationTotals& b) {
+        a.Penalty += b.Penalty;
+        a.Lanes.UsedLanes += b.Lanes.UsedLanes;
+        a.Lanes.TotalLanes += b.Lanes.TotalLanes;
+        return a;
+    }, [this] (int i) {
+        GenerationTotals drone;
+        drone.Penalty = DoDronePerformanceSimulation(Drones[i], i, drone.Lanes);
+        return drone;
+    });
+
+    LaneStats = totals.Lanes;
+    FP avgPenalty = totals.Penalty / GenerationSize;
 
-    std::sort(Drones.begin(), Drones.end(), [] (Drone& a, Drone& b) {
+    auto byScore = [] (const Drone& a, const Drone& b) {
         return a.TrainingScore < b.TrainingScore;
-    });
+    };
+    std::sort(Drones.begin(), Drones.end(), byScore);
 
-    Drones.erase(Drones.begin() + SelectNBest, Drones.end());
+    if constexpr (TrainingFineTuneInterval > 0) {
+        if ((GenerationsDone + 1) % TrainingFineTuneInterval == 0) {
+            FineTuneElites(TrainingFineTuneElites, TrainingFineTuneSteps, TrainingFineTuneLearningRate);
+            std::sort(Drones.begin(), Drones.end(), byScore);
+        }
+    }
 
     /*for (int i = 0; i < SelectNBest; i++) {
         auto numCrosses = GenerationSize / SelectNBest;
@@ -95,10 +261,7 @@ FP TrainingSim::TrainGeneration() {
         }
     }*/
 
-    static thread_local std::random_device rd {};
-    static thread_local std::mt19937 gen {rd()};
-
-    std::geometric_distribution<int> geom(Drones[0].TrainingScore / Drones[1].TrainingScore);
+    FP parentRatio = Drones[0].TrainingScore / Drones[1].TrainingScore;
 
     auto bestScore = Drones[0].TrainingScore;
 
@@ -106,53 +269,76 @@ FP TrainingSim::TrainGeneration() {
     //FP mutRate = std::min(std::pow(10.0, bestScore - 2), 1e-1);
 
 
-    while (Drones.size() < GenerationSize) {
-        auto index1 = std::min(geom(gen), (int) SelectNBest);
-        auto index2 = std::min(geom(gen), (int) SelectNBest);
+    ReproductionParams params {TrainingCrossover, mutRate, TrainingMutatedGenes};
+
+    // Children overwrite the drones that were not selected, reusing their genome buffers.
+    for (int i = SelectNBest; i < (int) GenerationSize; i++) {
+        CounterRng rng({Seed, (uint32_t) GenerationsDone, (uint32_t) i}, RngStream::Reproduction);
+        std::geometric_distribution<int> geom(parentRatio);
 
+        auto index1 = std::min(geom(rng), (int) SelectNBest - 1);
+        auto index2 = std::min(geom(rng), (int) SelectNBest - 1);
 
-        Drones.emplace_back(ControlNetwork::GenerateChild(mutRate, Drones[index1].Brain, Drones[index2].Brain));
+        Drones[i].Brain.Reproduce(params, Drones[index1].Brain, Drones[index2].Brain, rng);
+        Drones[i].CompiledBrain.reset();
     }
 
     GenerationsDone++;
     return avgPenalty;
 }
 
-void TrainingSim::SaveToFile() const {
-    std::ofstream file {CheckpointFileName};
-
-    file << GenerationsDone << "\n";
-    file << Hidden1Size << "\n";
-    file << Hidden2Size << "\n";
-
-    for (auto& drone : Drones) {
-        auto& brain = drone.Brain;
-
-        for (auto& arr : brain.InToH1Weights) {
-            for (auto& i : arr) file << i << "\n";
+void TrainingSim::FineTuneElites(int count, int steps, FP learningRate) {
+    // One elite per chunk: each is a long run of gradient steps.
+    pool.ParallelFor(0, count, 1, [this, steps, learningRate] (ll::IndexRange range) {
+        for (int i = range.Begin; i < range.End; i++) {
+            RngKey key {Seed, (uint32_t) GenerationsDone, (uint32_t) i};
+            CounterRng rng(key, RngStream::FineTune);
+
+            std::vector<Scenario> scenarios;
+            for (int j = 0; j < (int) SimulationsPerDrone; j++) {
+                scenarios.push_back({{rng.UniformFP(-TrainingMaxCoords, TrainingMaxCoords), rng.UniformFP(-TrainingMaxCoords, TrainingMaxCoords)}});
+            }
+
+            // The tuned penalty is a score over `SimulationsPerDrone` fresh training episodes, like any other drone's.
+            Drone& drone = Drones[i];
+            drone.TrainingScore = DifferentiableSim::FineTune(drone.Brain, scenarios, key, steps, learningRate);
+            drone.CompiledBrain.reset();
         }
+    }, ll::Partition::Guided);
+}
 
-        for (auto& arr : brain.H1ToH2Weights) {
-            for (auto& i : arr) file << i << "\n";
-        }
+void TrainingSim::WriteCheckpointHeader(std::ostream& file, int generations, int hidden1, int hidden2) {
+    file << generations << "\n";
+    file << hidden1 << "\n";
+    file << hidden2 << "\n";
+    file << ControlNetwork::ActivationType::Name << "\n";
+}
 
-        for (auto& arr : brain.H2ToOutWeights) {
-            for (auto& i : arr) file << i << "\n";
-        }
+void TrainingSim::SaveToFile(const char* fileName) const {
+    std::ofstream file {fileName};
+
+    WriteCheckpointHeader(file, GenerationsDone, Hidden1Size, Hidden2Size);
 
-        for (auto& i : brain.H1Biases) file << i << "\n";
-        for (auto& i : brain.H2Biases) file << i << "\n";
-        for (auto& i : brain.OutBiases) file << i << "\n";
+    for (auto& drone : Drones) {
+        for (auto& i : drone.Brain.GetGenome()) file << i << "\n";
     }
     std::cout << "Saved to checkpoint file." << std::endl;
 }
 
-void TrainingSim::LoadFromFile() {
-    std::ifstream file {CheckpointFileName};
+ll::TaskBatch TrainingSim::SaveToFileAsync(const char* fileName) const {
+    ll::TaskBatch batch;
+    pool.Post(batch, [snapshot = *this, fileName = std::string(fileName)] {
+        snapshot.SaveToFile(fileName.c_str());
+    });
+    return batch;
+}
+
+bool TrainingSim::LoadFromFile(const char* fileName) {
+    std::ifstream file {fileName};
 
     if (!file.is_open()) {
         std::cerr << "Could not open checkpoint file, skipping." << std::endl;
-        return;
+        return false;
     }
 
     int gens;
@@ -165,30 +351,28 @@ void TrainingSim::LoadFromFile() {
 
     if (h1 != Hidden1Size || h2 != Hidden2Size) {
         std::cerr << "Incorrect checkpoint architecture, aborting read." << std::endl;
-        return;
+        return false;
     }
 
-    GenerationsDone = gens;
+    // Checkpoints from before the activation was recorded were all trained with the leaky ReLU.
+    std::string activation {LeakyReLUActivation::Name};
+    file >> std::ws;
+    if (std::isalpha(file.peek())) file >> activation;
 
-    for (auto& drone : Drones) {
-        auto& brain = drone.Brain;
-
-        for (auto& arr : brain.InToH1Weights) {
-            for (auto& i : arr) file >> i;
-        }
+    if (activation != ControlNetwork::ActivationType::Name) {
+        std::cerr << "Checkpoint was trained with activation '" << activation << "', aborting read." << std::endl;
+        return false;
+    }
 
-        for (auto& arr : brain.H1ToH2Weights) {
-            for (auto& i : arr) file >> i;
-        }
+    GenerationsDone = gens;
 
-        for (auto& arr : brain.H2ToOutWeights) {
-            for (auto& i : arr) file >> i;
-        }
+    for (auto& drone : Drones) {
+        drone.CompiledBrain.reset();
 
-        for (auto& i : brain.H1Biases) file >> i;
-        for (auto& i : brain.H2Biases) file >> i;
-        for (auto& i : brain.OutBiases) file >> i;
+        for (auto& i : drone.Brain.GetGenome()) file >> i;
+        drone.Brain.UpdateLayout();
     }
 
     std::cout << "Loaded checkpoint file." << std::endl;
+    return true;
 }
\ No newline at end of file
@@ -1,17 +1,60 @@
 #pragma once
 
+#include <future>
+#include <iosfwd>
 #include <vector>
+#include "Config.hpp"
+#include "CounterRng.hpp"
 #include "Drone.hpp"
+#include "Scenario.hpp"
+
+#include <ThreadPool.hpp>
+
+// Lane slots of the lockstep episode batches: filled by a running episode, out of `TrainingEpisodeLanes` per control step.
+struct EpisodeLaneStats {
+    long UsedLanes = 0;
+    long TotalLanes = 0;
+
+    FP Utilization() const { return TotalLanes > 0 ? (FP) UsedLanes / TotalLanes : 0.0; }
+};
 
 struct TrainingSim {
     std::vector<Drone> Drones;
     int GenerationsDone = 0;
 
-    TrainingSim();
+    // Every random draw of the run derives from it (see `CounterRng.hpp`).
+    uint64_t Seed;
+
+    // Of the last `TrainGeneration`.
+    EpisodeLaneStats LaneStats;
+
+    // Randomizes the population on the training thread pool, each worker building and first writing its own slice.
+    TrainingSim(uint64_t seed = TrainingSeed);
 
-    FP DoDronePerformanceSimulation(Drone& drone);
+    // The thread pool every `TrainingSim` trains on.
+    static ll::ThreadPool& GetPool();
+
+    // Builds a new population off the calling thread. It only waits for its own tasks, so the pool can keep training meanwhile.
+    static std::future<TrainingSim> CreateAsync(uint64_t seed);
+
+    // Scores the drone at population index `index`, which keys its random scenarios, and adds its lane slots to `laneStats`.
+    FP DoDronePerformanceSimulation(Drone& drone, int index, EpisodeLaneStats& laneStats);
     FP TrainGeneration();
 
-    void SaveToFile() const;
-    void LoadFromFile();
+    // Mean penalty of `net` over `SimulationsPerDrone` scenarios, flown exactly like the training episodes of the drone
+    // keyed by `key` (initial states, integrator, control interval) with the interpreted network.
+    static FP EpisodePenalty(const ControlNetwork& net, const std::vector<Scenario>& scenarios, const RngKey& key);
+
+    // Gradient fine-tuning of the first `count` drones (the elites, once sorted) on fresh training scenarios.
+    // Their `TrainingScore` becomes the tuned penalty on those scenarios.
+    void FineTuneElites(int count, int steps, FP learningRate);
+
+    void SaveToFile(const char* fileName = CheckpointFileName) const;
+    // Writes a copy of the population from the training pool, so training goes on while the file is written.
+    // The file is complete once the returned batch is done.
+    ll::TaskBatch SaveToFileAsync(const char* fileName = CheckpointFileName) const;
+    bool LoadFromFile(const char* fileName = CheckpointFileName);
+
+    // Checkpoint header: generations, hidden layer sizes and activation name. Followed by `GenerationSize` genomes.
+    static void WriteCheckpointHeader(std::ostream& file, int generations, int hidden1, int hidden2);
 };
\ No newline at end of file
@@ -1,31 +1,94 @@
 #pragma once
 
+#include <cmath>
+#include <type_traits>
+
 #include "FPType.hpp"
+#include "Simd.hpp"
+
+// 2D vector over `T`. Instantiated with `FP` as `Vec2` and with `FPVec` as `Vec2xN` (in `Vec2xN.hpp`), which holds
+// `SimdWidth` vectors in structure-of-arrays form, so code written against the operators below works on one drone or on
+// a batch of them.
+template <class T>
+struct BasicVec2 {
+    static constexpr bool IsBatch = !std::is_same_v<T, FP>;
+
+    T x;
+    T y;
+
+    constexpr BasicVec2() : x(T {}), y(T {}) { }
+    constexpr BasicVec2(T scalar) : x(scalar), y(scalar) { }
+    constexpr BasicVec2(T x, T y) : x(x), y(y) { }
+
+    // Broadcasts to every lane of a batch.
+    constexpr BasicVec2(FP scalar) requires IsBatch : x(T {} + scalar), y(T {} + scalar) { }
+    constexpr BasicVec2(FP x, FP y) requires IsBatch : x(T {} + x), y(T {} + y) { }
+
+    // A template, so for `Vec2` it does not replace the implicit copy constructor.
+    template <class U>
+    requires IsBatch && std::is_same_v<U, FP>
+    constexpr BasicVec2(const BasicVec2<U>& v) : x(T {} + v.x), y(T {} + v.y) { }
 
-struct Vec2 {
-    FP x;
-    FP y;
+    // `Vec2xN.hpp` specializes `Mag` and `Rotated` for batches with the SIMD math library.
+    T Mag() const {
+        return std::sqrt(Mag2());
+    }
 
-    constexpr Vec2() : x(0.0), y(0.0) { }
-    constexpr Vec2(FP scalar) : x(scalar), y(scalar) { }
-    constexpr Vec2(FP x, FP y) : x(x), y(y) { }
-    constexpr Vec2(const Vec2& b) : x(b.x), y(b.y) { }
+    constexpr T Mag2() const {
+        return x * x + y * y;
+    }
 
-    constexpr void operator = (const Vec2& other) {
-        x = other.x;
-        y = other.y;
+    BasicVec2 Rotated(T angle) const {
+        T s = std::sin(angle);
+        T c = std::cos(angle);
+        return {x * c - y * s, x * s + y * c};
     }
 
-    FP Mag() const;
-    FP Mag2() const;
+    BasicVec2<FP> Lane(int i) const requires IsBatch {
+        return {x[i], y[i]};
+    }
 
-    Vec2 Rotated(FP angle);
+    void SetLane(int i, const BasicVec2<FP>& v) requires IsBatch {
+        x[i] = v.x;
+        y[i] = v.y;
+    }
 
-    Vec2& operator += (const Vec2& other);
-};
+    constexpr BasicVec2& operator += (const BasicVec2& other) {
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
 
-Vec2 operator + (const Vec2& a, const Vec2& b);
-Vec2 operator - (const Vec2& a, const Vec2& b);
+    constexpr BasicVec2& operator -= (const BasicVec2& other) {
+        x -= other.x;
+        y -= other.y;
+        return *this;
+    }
+
+    friend constexpr BasicVec2 operator + (const BasicVec2& a, const BasicVec2& b) {
+        return {a.x + b.x, a.y + b.y};
+    }
+
+    friend constexpr BasicVec2 operator - (const BasicVec2& a, const BasicVec2& b) {
+        return {a.x - b.x, a.y - b.y};
+    }
+
+    friend constexpr BasicVec2 operator - (const BasicVec2& a) {
+        return {-a.x, -a.y};
+    }
+
+    // Scalars are `FP`, or per-lane `FPVec`s for a batch.
+    template <class S>
+    requires std::is_arithmetic_v<S> || std::is_same_v<S, T>
+    friend constexpr BasicVec2 operator * (const BasicVec2& a, S scalar) {
+        return {a.x * scalar, a.y * scalar};
+    }
+
+    template <class S>
+    requires std::is_arithmetic_v<S> || std::is_same_v<S, T>
+    friend constexpr BasicVec2 operator / (const BasicVec2& a, S scalar) {
+        return {a.x / scalar, a.y / scalar};
+    }
+};
 
-Vec2 operator * (const Vec2& a, FP scalar);
-Vec2 operator / (const Vec2& a, FP scalar);
\ No newline at end of file
+using Vec2 = BasicVec2<FP>;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Simd.hpp"
+#include "Vec2.hpp"
+#include "VectorMath.hpp"
+
+using Vec2xN = BasicVec2<FPVec>;
+
+template <>
+inline FPVec Vec2xN::Mag() const {
+    return VectorSqrt(Mag2());
+}
+
+template <>
+inline Vec2xN Vec2xN::Rotated(FPVec angle) const {
+    FPVec s, c;
+    VectorSinCos(angle, s, c);
+    return {x * c - y * s, x * s + y * c};
+}
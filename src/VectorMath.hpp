@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <span>
+
+#include <immintrin.h>
+
+#include "Simd.hpp"
+
+// Elementary functions on whole `FPVec`s, for loops over many drones that libm calls would keep scalar.
+// Valid for |x| < 2^20 (far beyond any angle the simulation produces); accuracy is chosen per call site.
+
+enum class VectorAccuracy {
+    Fast,       // Absolute error below 4e-7, for inputs to the network or rendering.
+    Medium,     // Below 1e-11.
+    Full,       // Within one ulp of libm.
+};
+
+// Lanes of 64-bit integers matching `FPVec`.
+using IntVec = int64_t __attribute__((vector_size(SimdBytes)));
+
+static_assert(sizeof(FP) == 8, "VectorMath works on 64-bit floats");
+
+constexpr int64_t VectorSignBit = INT64_MIN;
+
+inline FPVec VectorFma(FPVec a, FPVec b, FPVec c) {
+#if defined(__AVX512F__)
+    return _mm512_fmadd_pd(a, b, c);
+#elif defined(__AVX__) && defined(__FMA__)
+    return _mm256_fmadd_pd(a, b, c);
+#elif defined(__FMA__)
+    return _mm_fmadd_pd(a, b, c);
+#else
+    for (int i = 0; i < SimdWidth; i++) a[i] = std::fma(a[i], b[i], c[i]);
+    return a;
+#endif
+}
+
+// Correctly rounded, like `std::sqrt`; the instruction is already as fast as any approximation.
+inline FPVec VectorSqrt(FPVec x) {
+#if defined(__AVX512F__)
+    // Full mask; the unmasked intrinsic trips -Wuninitialized in GCC 12's headers.
+    return _mm512_maskz_sqrt_pd(0xff, x);
+#elif defined(__AVX__)
+    return _mm256_sqrt_pd(x);
+#else
+    return _mm_sqrt_pd(x);
+#endif
+}
+
+// Round to the nearest integer (ties to even), valid below 2^51.
+inline FPVec VectorRound(FPVec x) {
+    constexpr FP shift = 0x1.8p52;
+    return (x + shift) - shift;
+}
+
+// Round towards zero, valid below 2^51.
+inline FPVec VectorTrunc(FPVec x) {
+    constexpr FP shift = 0x1.8p52;
+    FPVec magnitude = (FPVec) ((IntVec) x & ~VectorSignBit);
+    FPVec rounded = (magnitude + shift) - shift;
+    rounded = rounded > magnitude ? rounded - 1.0 : rounded;
+    return (FPVec) ((IntVec) rounded | ((IntVec) x & VectorSignBit));
+}
+
+// `std::fmod(x, 2 pi)` lane-wise, bit-exact: the remainder is representable, so one fused multiply-add gives it
+// exactly once the quotient is right, and a wrong quotient at the boundaries is fixed by one more period.
+inline FPVec VectorWrapAngle(FPVec x) {
+    constexpr FP period = 2.0 * std::numbers::pi;
+
+    FPVec quotient = VectorTrunc(x * (1.0 / period));
+    FPVec r = VectorFma(-quotient, SimdBroadcast(period), x);
+
+    // The quotient can be one off near multiples of the period; the remainder must have the sign of `x`
+    // and a magnitude below the period. Recomputing after the fix keeps it exact.
+    FPVec sign = (FPVec) ((IntVec) x & VectorSignBit);
+    FPVec step = (FPVec) ((IntVec) SimdBroadcast(1.0) | (IntVec) sign);
+
+    IntVec under = x >= 0.0 ? r < 0.0 : r > 0.0;
+    IntVec over = x >= 0.0 ? r >= period : r <= -period;
+    quotient = under ? quotient - step : over ? quotient + step : quotient;
+    r = VectorFma(-quotient, SimdBroadcast(period), x);
+
+    // fmod keeps the sign of `x` on an exact zero.
+    return r == 0.0 ? sign : r;
+}
+
+// Natural logarithm of positive normal lanes: exponent plus an odd series of atanh((m - 1) / (m + 1)), relative error below 1e-13.
+inline FPVec VectorLog(FPVec x) {
+    IntVec bits = (IntVec) x;
+    IntVec exponent = ((bits >> 52) & 0x7ff) - 1023;
+    FPVec m = (FPVec) ((bits & 0x000fffffffffffff) | 0x3ff0000000000000);
+
+    // Mantissa in [sqrt(1/2), sqrt(2)) keeps the series argument below 0.172.
+    IntVec high = m > std::numbers::sqrt2;
+    m = high ? m * 0.5 : m;
+    exponent -= high;
+
+    FPVec f = (m - 1.0) / (m + 1.0);
+    FPVec f2 = f * f;
+    FPVec series = SimdBroadcast(1.0 / 15.0);
+    for (FP k : {13.0, 11.0, 9.0, 7.0, 5.0, 3.0, 1.0}) series = series * f2 + 1.0 / k;
+
+    return 2.0 * f * series + __builtin_convertvector(exponent, FPVec) * std::numbers::ln2;
+}
+
+template <VectorAccuracy Accuracy = VectorAccuracy::Full>
+inline void VectorSinCos(FPVec x, FPVec& sinOut, FPVec& cosOut) {
+    // x = k pi/2 + r, with pi/2 split in three parts so k * part is exact for k < 2^20 (Cody-Waite).
+    constexpr FP pio2Hi = 1.57079632673412561417e+00;
+    constexpr FP pio2Mid = 6.07710050630396597660e-11;
+    constexpr FP pio2Lo = 2.02226624879595063154e-21;
+
+    FPVec k = VectorRound(x * (2.0 / std::numbers::pi));
+    FPVec r = ((x - k * pio2Hi) - k * pio2Mid) - k * pio2Lo;
+    FPVec z = r * r;
+
+    FPVec s, c;
+    if constexpr (Accuracy == VectorAccuracy::Full) {
+        // fdlibm kernel coefficients, minimax on [-pi/4, pi/4].
+        FPVec sp = SimdBroadcast(1.58969099521155010221e-10);
+        sp = sp * z - 2.50507602534068634195e-08;
+        sp = sp * z + 2.75573137070700676789e-06;
+        sp = sp * z - 1.98412698298579493134e-04;
+        sp = sp * z + 8.33333333332248946124e-03;
+        sp = sp * z - 1.66666666666666324348e-01;
+        s = r + r * z * sp;
+
+        FPVec cp = SimdBroadcast(-1.13596475577881948265e-11);
+        cp = cp * z + 2.08757232129817482790e-09;
+        cp = cp * z - 2.75573143513906633035e-07;
+        cp = cp * z + 2.48015872894767294178e-05;
+        cp = cp * z - 1.38888888888741095749e-03;
+        cp = cp * z + 4.16666666666666019037e-02;
+        c = 1.0 - (0.5 * z - z * z * cp);
+    }
+    else if constexpr (Accuracy == VectorAccuracy::Medium) {
+        s = r * (1.0 - z * (1.0 / 6) * (1.0 - z * (1.0 / 20) * (1.0 - z * (1.0 / 42) * (1.0 - z * (1.0 / 72) * (1.0 - z * (1.0 / 110))))));
+        c = 1.0 - z * 0.5 * (1.0 - z * (1.0 / 12) * (1.0 - z * (1.0 / 30) * (1.0 - z * (1.0 / 56) * (1.0 - z * (1.0 / 90) * (1.0 - z * (1.0 / 132))))));
+    }
+    else {
+        s = r * (1.0 - z * (1.0 / 6) * (1.0 - z * (1.0 / 20) * (1.0 - z * (1.0 / 42))));
+        c = 1.0 - z * 0.5 * (1.0 - z * (1.0 / 12) * (1.0 - z * (1.0 / 30) * (1.0 - z * (1.0 / 56))));
+    }
+
+    // Quadrant: odd k swaps sin and cos, then signs follow k mod 4.
+    IntVec q = __builtin_convertvector(k, IntVec);
+    IntVec swap = (q & 1) != 0;
+    FPVec sinBase = swap ? c : s;
+    FPVec cosBase = swap ? s : c;
+
+    IntVec sinSign = (q & 2) << 62;
+    IntVec cosSign = ((q + 1) & 2) << 62;
+    sinOut = (FPVec) ((IntVec) sinBase ^ sinSign);
+    cosOut = (FPVec) ((IntVec) cosBase ^ cosSign);
+}
+
+// Span versions. The tail is padded into one more vector, so any length works.
+template <VectorAccuracy Accuracy = VectorAccuracy::Full>
+void VectorSinCos(std::span<const FP> x, std::span<FP> sinOut, std::span<FP> cosOut) {
+    size_t n = x.size();
+    size_t i = 0;
+
+    for (; i + SimdWidth <= n; i += SimdWidth) {
+        FPVec s, c;
+        VectorSinCos<Accuracy>(SimdLoad(x.data() + i), s, c);
+        SimdStore(sinOut.data() + i, s);
+        SimdStore(cosOut.data() + i, c);
+    }
+
+    if (i < n) {
+        FP padded[SimdWidth] = {};
+        std::copy(x.begin() + i, x.end(), padded);
+
+        FPVec s, c;
+        VectorSinCos<Accuracy>(SimdLoad(padded), s, c);
+        for (size_t j = i; j < n; j++) {
+            sinOut[j] = s[j - i];
+            cosOut[j] = c[j - i];
+        }
+    }
+}
+
+// `out = func(x)` over spans, for the single-argument functions above.
+template <class F>
+void VectorApply(std::span<const FP> x, std::span<FP> out, const F& func) {
+    size_t n = x.size();
+    size_t i = 0;
+
+    for (; i + SimdWidth <= n; i += SimdWidth) SimdStore(out.data() + i, func(SimdLoad(x.data() + i)));
+
+    if (i < n) {
+        FP padded[SimdWidth] = {};
+        std::copy(x.begin() + i, x.end(), padded);
+
+        FPVec result = func(SimdLoad(padded));
+        for (size_t j = i; j < n; j++) out[j] = result[j - i];
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace ll {
+    // Recycled fixed-size blocks. Each thread keeps a small cache and trades batches with a shared free list, so blocks
+    // freed on another thread (a promise state released by the worker that ran its task) come back without the heap.
+    // Blocks are never returned to the heap.
+    template <size_t Size, size_t Align>
+    class BlockPool {
+        private:
+            struct Block {
+                Block* next;
+            };
+
+            static constexpr size_t blockAlign = std::max(Align, alignof(Block));
+            static constexpr size_t blockSize = (std::max(Size, sizeof(Block)) + blockAlign - 1) / blockAlign * blockAlign;
+            static constexpr int batch = 32;
+
+            struct Shared {
+                std::mutex mutex;
+                Block* head = nullptr;
+            };
+
+            struct Cache {
+                Block* head = nullptr;
+                int count = 0;
+
+                ~Cache() {
+                    Give(*this, count);
+                }
+            };
+
+            // Never destroyed: pool threads can still free blocks during static destruction.
+            static Shared& GetShared() {
+                static Shared* shared = new Shared;
+                return *shared;
+            }
+
+            static Cache& GetCache() {
+                static thread_local Cache cache;
+                return cache;
+            }
+
+            static void Take(Cache& cache) {
+                Shared& shared = GetShared();
+                std::lock_guard _(shared.mutex);
+                for (int i = 0; i < batch && shared.head; i++) {
+                    Block* block = shared.head;
+                    shared.head = block->next;
+                    block->next = cache.head;
+                    cache.head = block;
+                    cache.count++;
+                }
+            }
+
+            static void Give(Cache& cache, int count) {
+                Shared& shared = GetShared();
+                std::lock_guard _(shared.mutex);
+                for (int i = 0; i < count && cache.head; i++) {
+                    Block* block = cache.head;
+                    cache.head = block->next;
+                    cache.count--;
+                    block->next = shared.head;
+                    shared.head = block;
+                }
+            }
+
+        public:
+            static void* Allocate() {
+                Cache& cache = GetCache();
+                if (!cache.head) Take(cache);
+                if (!cache.head) return ::operator new(blockSize, std::align_val_t(blockAlign));
+
+                Block* block = cache.head;
+                cache.head = block->next;
+                cache.count--;
+                return block;
+            }
+
+            static void Deallocate(void* p) {
+                Cache& cache = GetCache();
+                Block* block = static_cast<Block*>(p);
+                block->next = cache.head;
+                cache.head = block;
+                cache.count++;
+
+                if (cache.count > 2 * batch) Give(cache, batch);
+            }
+    };
+
+    // Allocator over `BlockPool`, for single objects (like the shared state of `std::promise`); arrays use the heap.
+    template <class T>
+    struct PoolAllocator {
+        using value_type = T;
+
+        PoolAllocator() = default;
+
+        template <class U>
+        PoolAllocator(const PoolAllocator<U>&) { }
+
+        T* allocate(size_t n) {
+            if (n != 1) return std::allocator<T>().allocate(n);
+            return static_cast<T*>(BlockPool<sizeof(T), alignof(T)>::Allocate());
+        }
+
+        void deallocate(T* p, size_t n) {
+            if (n != 1) return std::allocator<T>().deallocate(p, n);
+            BlockPool<sizeof(T), alignof(T)>::Deallocate(p);
+        }
+
+        template <class U>
+        bool operator== (const PoolAllocator<U>&) const { return true; }
+    };
+}
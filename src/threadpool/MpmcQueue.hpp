@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace ll {
+    // Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's ring buffer). Every cell carries a
+    // sequence number telling producers and consumers whose turn it is, so each side only contends on its own index.
+    template <class T>
+    class MpmcQueue {
+        private:
+            struct Cell {
+                std::atomic<size_t> sequence;
+                T value;
+            };
+
+            std::unique_ptr<Cell[]> cells;
+            size_t mask;
+
+            alignas(64) std::atomic<size_t> enqueuePos {0};
+            alignas(64) std::atomic<size_t> dequeuePos {0};
+
+        public:
+            // Capacity must be a power of two.
+            explicit MpmcQueue(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1) {
+                for (size_t i = 0; i < capacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            MpmcQueue(const MpmcQueue&) = delete;
+            MpmcQueue& operator= (const MpmcQueue&) = delete;
+
+            // Returns false, leaving `value` untouched, when the queue is full.
+            bool TryPush(T&& value) {
+                Cell* cell;
+                size_t pos = enqueuePos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell = &cells[pos & mask];
+                    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+                    if (diff == 0) {
+                        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    }
+                    else if (diff < 0) {
+                        return false;
+                    }
+                    else {
+                        pos = enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                cell->value = std::move(value);
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Returns false when the queue is empty.
+            bool TryPop(T& value) {
+                Cell* cell;
+                size_t pos = dequeuePos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell = &cells[pos & mask];
+                    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+
+                    if (diff == 0) {
+                        if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    }
+                    else if (diff < 0) {
+                        return false;
+                    }
+                    else {
+                        pos = dequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                value = std::move(cell->value);
+                cell->value = T {};
+                cell->sequence.store(pos + mask + 1, std::memory_order_release);
+                return true;
+            }
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ll {
+    // FIFO queue over a circular buffer that only grows, so a queue in steady use stops allocating.
+    // Same interface as the parts of `std::queue` the pool uses.
+    template <class T>
+    class RingQueue {
+        private:
+            std::vector<T> slots;
+            size_t head = 0;
+            size_t count = 0;
+
+            void Grow() {
+                std::vector<T> grown(std::max<size_t>(16, slots.size() * 2));
+                for (size_t i = 0; i < count; i++) grown[i] = std::move(slots[(head + i) & (slots.size() - 1)]);
+                slots.swap(grown);
+                head = 0;
+            }
+
+        public:
+            bool empty() const { return count == 0; }
+            size_t size() const { return count; }
+
+            T& front() { return slots[head]; }
+
+            void push(T&& value) {
+                if (count == slots.size()) Grow();
+                slots[(head + count) & (slots.size() - 1)] = std::move(value);
+                count++;
+            }
+
+            void pop() {
+                slots[head] = T {};
+                head = (head + 1) & (slots.size() - 1);
+                count--;
+            }
+    };
+}
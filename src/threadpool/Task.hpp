@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ll {
+    // Move-only `void()` callable. Callables of up to `InlineSize` bytes that move without throwing are stored in place,
+    // so wrapping one does not allocate; larger ones go to the heap. Each object is one cache line.
+    class Task {
+        public:
+            static constexpr size_t InlineSize = 56;
+
+        private:
+            struct Ops {
+                void (*invoke)(void* target);
+                // Move-constructs into `to` and destroys `from`.
+                void (*relocate)(void* from, void* to);
+                void (*destroy)(void* target);
+            };
+
+            template <class F>
+            static constexpr bool storedInline = sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+            template <class F>
+            static constexpr Ops inlineOps = {
+                [] (void* target) { (*static_cast<F*>(target))(); },
+                [] (void* from, void* to) {
+                    new (to) F(std::move(*static_cast<F*>(from)));
+                    static_cast<F*>(from)->~F();
+                },
+                [] (void* target) { static_cast<F*>(target)->~F(); },
+            };
+
+            template <class F>
+            static constexpr Ops heapOps = {
+                [] (void* target) { (**static_cast<F**>(target))(); },
+                [] (void* from, void* to) { new (to) F*(*static_cast<F**>(from)); },
+                [] (void* target) { delete *static_cast<F**>(target); },
+            };
+
+            alignas(std::max_align_t) std::byte storage[InlineSize];
+            const Ops* ops = nullptr;
+
+        public:
+            Task() = default;
+            Task(std::nullptr_t) { }
+
+            template <class F>
+            requires (!std::is_same_v<std::decay_t<F>, Task>) && std::is_invocable_r_v<void, std::decay_t<F>&>
+            Task(F&& func) {
+                using D = std::decay_t<F>;
+                if constexpr (storedInline<D>) {
+                    new (storage) D(std::forward<F>(func));
+                    ops = &inlineOps<D>;
+                }
+                else {
+                    new (storage) D*(new D(std::forward<F>(func)));
+                    ops = &heapOps<D>;
+                }
+            }
+
+            Task(Task&& other) noexcept : ops(other.ops) {
+                if (ops) ops->relocate(other.storage, storage);
+                other.ops = nullptr;
+            }
+
+            Task& operator= (Task&& other) noexcept {
+                if (this != &other) {
+                    Reset();
+                    ops = other.ops;
+                    if (ops) ops->relocate(other.storage, storage);
+                    other.ops = nullptr;
+                }
+                return *this;
+            }
+
+            Task& operator= (std::nullptr_t) {
+                Reset();
+                return *this;
+            }
+
+            Task(const Task&) = delete;
+            Task& operator= (const Task&) = delete;
+
+            ~Task() {
+                Reset();
+            }
+
+            explicit operator bool() const {
+                return ops != nullptr;
+            }
+
+            void operator()() {
+                ops->invoke(storage);
+            }
+
+            // Destroys the stored callable, if any.
+            void Reset() {
+                if (ops) ops->destroy(storage);
+                ops = nullptr;
+            }
+    };
+
+    static_assert(sizeof(Task) == 64);
+}
@@ -4,6 +4,46 @@
 
 using namespace ll;
 
+// Set on the workers of a pool, so submissions from inside a task can go to the local deque.
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+// Work-stealing deques hold pointers; the tasks they point to live in recycled blocks.
+using TaskNodes = BlockPool<sizeof(Task), alignof(Task)>;
+
+static Task* NewTaskNode(Task&& task) {
+    return new (TaskNodes::Allocate()) Task(std::move(task));
+}
+
+static void DeleteTaskNode(Task* task) {
+    task->~Task();
+    TaskNodes::Deallocate(task);
+}
+
+TaskBatch::TaskBatch() : state(std::allocate_shared<State>(PoolAllocator<State>())) { }
+
+void TaskBatch::Wait() {
+    int pending;
+    while ((pending = state->pending.load(std::memory_order_acquire)) != 0) {
+        state->pending.wait(pending, std::memory_order_acquire);
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard _(state->errorMutex);
+        std::swap(error, state->error);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+bool TaskBatch::IsDone() const {
+    return state->pending.load(std::memory_order_acquire) == 0;
+}
+
+int TaskBatch::GetPending() const {
+    return state->pending.load(std::memory_order_acquire);
+}
+
 void TaskGroupFuture::Get() {
     for (auto& fut : futures) {
         fut.get();
@@ -16,40 +56,52 @@ void TaskGroupFuture::Wait() {
     }
 }
 
-ThreadPool::ThreadPool(const size_t numThreads) {
+ThreadPool::ThreadPool(const size_t numThreads, Scheduler scheduler, const Placement& placement) : scheduler(scheduler) {
     if (numThreads == 0) {
         throw std::invalid_argument("Tried to create ThreadPool with 0 threads.");
     }
     stopped = false;
     paused = true;
-    workflags = new bool[numThreads];
     threads.reserve(numThreads);
+    if (scheduler == Scheduler::WorkStealing) {
+        for (size_t i = 0; i < numThreads; i++) deques.push_back(std::make_unique<WorkStealingDeque<Task*>>());
+    }
+    if (scheduler == Scheduler::LockFreeQueue) {
+        ring = std::make_unique<MpmcQueue<Task>>(lockFreeCapacity);
+    }
     for (size_t i = 0; i < numThreads; i++) {
-        workflags[i] = false;
-        threads.emplace_back(&ThreadPool::WorkerFunc, this, i);
+        if (scheduler == Scheduler::LockFreeQueue) threads.emplace_back(&ThreadPool::LockFreeWorkerFunc, this, i);
+        else threads.emplace_back(&ThreadPool::WorkerFunc, this, i);
         idMap.insert_or_assign(threads[i].get_id(), i);
     }
+    SetPlacement(placement);
     Start();
 }
 
 ThreadPool::~ThreadPool() {
-    if (stopped || paused || tasks.empty()) {
-        stopped = true;
-        cv.notify_all();
+    if (stopped || paused || NoQueuedTasks()) {
+        Stop();
         JoinThreads();
-        delete[] workflags;
+        DrainQueues();
         return;
     }
     WaitUntilEmpty();
     Stop();
     JoinThreads();
-    delete[] workflags;
+}
+
+void ThreadPool::SetPlacement(const Placement& placement) {
+    workerCpus = placement.WorkerCpus(threads.size());
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (!PinThread(threads[i], workerCpus[i])) workerCpus[i] = -1;
+    }
 }
 
 void ThreadPool::Start() {
     stopped = false;
     paused = false;
     cv.notify_all();
+    WakeWorkers(true);
 }
 
 void ThreadPool::JoinThreads() {
@@ -59,67 +111,210 @@ void ThreadPool::JoinThreads() {
 }
 
 void ThreadPool::Stop() {
-    stopped = true;
+    {
+        std::lock_guard _(workerMutex);
+        stopped = true;
+    }
     cv.notify_all();
+    WakeWorkers(true);
 }
 
 void ThreadPool::Pause() {
     paused = true;
 }
 
+// Shared queue and work stealing; the shared queue is the injection queue without any deques.
 void ThreadPool::WorkerFunc(int tid) {
+    currentPool = this;
+    currentWorker = tid;
+    uint32_t victimSeed = 2654435761u * (tid + 1);
+
     while (true) {
-        std::function<void()> job;
-        {
+        Task* task = paused ? nullptr : FindTask(tid, victimSeed);
+
+        if (task == nullptr) {
+            // Pairs with the check of `sleepingWorkers` in `PushTask`: either the pusher sees this worker asleep and
+            // notifies, or this worker sees the new task in the predicate.
             std::unique_lock lock(workerMutex);
-            cv.wait(lock, [this] { return (!tasks.empty() && !paused) || stopped; });
+            sleepingWorkers++;
+            cv.wait(lock, [this] { return (queuedTasks > 0 && !paused) || stopped; });
+            sleepingWorkers--;
             if (stopped) {
                 return;
             }
+            continue;
+        }
 
-            std::lock_guard _(queueMutex);
-            job = std::move(tasks.front());
-            tasks.pop();
+        busyWorkers++;
+        queuedTasks--;
+        (*task)();
+        DeleteTaskNode(task);
+        FinishTask();
+    }
+}
+
+void ThreadPool::LockFreeWorkerFunc(int tid) {
+    currentPool = this;
+    currentWorker = tid;
+    Task task;
+
+    while (true) {
+        if (!paused && RunRingTask(task)) continue;
+
+        // Either `PushTask` sees this worker asleep and bumps `wakeups`, so the wait returns at once,
+        // or the new task is already counted in `queuedTasks` here.
+        sleepingWorkers++;
+        uint32_t epoch = wakeups.load();
+        if (!stopped && (queuedTasks == 0 || paused)) wakeups.wait(epoch);
+        sleepingWorkers--;
+
+        if (stopped) {
+            return;
+        }
+    }
+}
+
+// Runs one task from the ring, if there is any. `task` is scratch storage, kept to reuse its buffer.
+bool ThreadPool::RunRingTask(Task& task) {
+    if (!ring->TryPop(task)) return false;
+
+    busyWorkers++;
+    queuedTasks--;
+    task();
+    task = nullptr;
+    FinishTask();
+    return true;
+}
+
+void ThreadPool::FinishTask() {
+    busyWorkers--;
+    if (--unfinishedTasks == 0 || paused) unfinishedTasks.notify_all();
+}
 
-            workflags[tid] = true;
+void ThreadPool::WakeWorkers(bool all) {
+    if (scheduler != Scheduler::LockFreeQueue) return;
+    wakeups++;
+    if (all) wakeups.notify_all();
+    else wakeups.notify_one();
+}
+
+// Own deque first (newest task, still in cache), then the injection queue, then the other deques from a random victim on.
+Task* ThreadPool::FindTask(int tid, uint32_t& victimSeed) {
+    if (scheduler == Scheduler::WorkStealing) {
+        if (Task* task = deques[tid]->Pop()) return task;
+    }
+
+    if (injectedTasks > 0) {
+        std::lock_guard _(queueMutex);
+        if (!tasks.empty()) {
+            Task* task = NewTaskNode(std::move(tasks.front()));
+            tasks.pop();
+            injectedTasks--;
+            return task;
         }
-        job();
-        {
-            std::lock_guard _(workerMutex);
-            workflags[tid] = false;
+    }
+
+    if (scheduler != Scheduler::WorkStealing) return nullptr;
+
+    victimSeed ^= victimSeed << 13;
+    victimSeed ^= victimSeed >> 17;
+    victimSeed ^= victimSeed << 5;
+
+    int numDeques = deques.size();
+    for (int i = 0; i < numDeques; i++) {
+        int victim = (victimSeed + i) % numDeques;
+        if (victim == tid) continue;
+        if (Task* task = deques[victim]->Steal()) return task;
+    }
+    return nullptr;
+}
+
+void ThreadPool::PushTask(Task&& task) {
+    unfinishedTasks++;
+    if (scheduler == Scheduler::LockFreeQueue) {
+        Task help;
+        while (!ring->TryPush(std::move(task))) {
+            // Full: a worker waiting for room could be the one that has to make it.
+            if (currentPool != this || !RunRingTask(help)) std::this_thread::yield();
         }
+        queuedTasks++;
+
+        if (sleepingWorkers > 0) WakeWorkers(false);
+        return;
+    }
+
+    if (currentPool == this && scheduler == Scheduler::WorkStealing) {
+        deques[currentWorker]->Push(NewTaskNode(std::move(task)));
+    }
+    else {
+        std::lock_guard lock(queueMutex);
+        tasks.push(std::move(task));
+        injectedTasks++;
+    }
+    queuedTasks++;
+
+    if (sleepingWorkers > 0) {
+        { std::lock_guard _(workerMutex); }
         cv.notify_one();
-        if (tasks.empty()) doneCV.notify_all();
     }
 }
 
-void ThreadPool::Clear() {
+// Removes every queued task and returns how many there were.
+long ThreadPool::DrainQueues() {
     std::lock_guard lock(queueMutex);
+    long removed = tasks.size();
     tasks = {};
+    injectedTasks = 0;
+
+    if (scheduler == Scheduler::WorkStealing) {
+        for (auto& deque : deques) {
+            while (deque->Size() > 0) {
+                if (Task* task = deque->Steal()) {
+                    DeleteTaskNode(task);
+                    removed++;
+                }
+            }
+        }
+    }
+
+    if (scheduler == Scheduler::LockFreeQueue) {
+        Task task;
+        long popped = 0;
+        while (ring->TryPop(task)) popped++;
+        removed += popped;
+    }
+
+    queuedTasks -= removed;
+    if ((unfinishedTasks -= removed) == 0) unfinishedTasks.notify_all();
+    return removed;
+}
+
+void ThreadPool::Clear() {
+    DrainQueues();
 }
 
 void ThreadPool::WaitUntilEmpty() {
-    std::unique_lock lock(doneMutex);
-    doneCV.wait(lock, [this] {return (tasks.empty() || paused) && AllThreadsDone();});
+    long unfinished;
+    while ((unfinished = unfinishedTasks.load()) != 0 && !(paused && busyWorkers == 0)) {
+        unfinishedTasks.wait(unfinished);
+    }
 }
 
-void ThreadPool::Resume() {
-    paused = false;
-    cv.notify_all();
+bool ThreadPool::NoQueuedTasks() const {
+    return queuedTasks == 0;
 }
 
-bool ThreadPool::AllThreadsDone() {
-    std::lock_guard _(workerMutex);
-    for (size_t i = 0; i < this->threads.size(); i++) {
-        bool b = workflags[i];
-        if (b) return false;
+void ThreadPool::Resume() {
+    {
+        std::lock_guard _(workerMutex);
+        paused = false;
     }
-    return true;
+    cv.notify_all();
+    WakeWorkers(true);
 }
 
 unsigned int ThreadPool::GetRemainingTasks() const {
-    std::lock_guard lock(queueMutex);
-    return tasks.size();
+    return queuedTasks;
 }
 
 int ThreadPool::GetThreadIndex() const {
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <latch>
+#include <optional>
+#include <ranges>
 #include <type_traits>
 #include <vector>
 #include <queue>
@@ -11,9 +17,126 @@
 #include <future>
 #include <memory>
 
+#include "BlockPool.hpp"
+#include "MpmcQueue.hpp"
+#include "RingQueue.hpp"
+#include "Task.hpp"
+#include "Topology.hpp"
+#include "WorkStealingDeque.hpp"
+
 
 namespace ll {
     class ThreadPool;
+
+    // How a ThreadPool hands tasks to its workers.
+    enum class Scheduler {
+        // One queue shared by every worker, behind a mutex.
+        SharedQueue,
+        // A Chase–Lev deque per worker. Tasks submitted from a worker go to its own deque, and idle workers steal
+        // from random victims. Tasks submitted from other threads go to a shared injection queue.
+        WorkStealing,
+        // One bounded lock-free ring (`MpmcQueue`) shared by every worker, with idle workers parked on `std::atomic::wait`.
+        // When the ring is full, submitters wait for room, or run queued tasks themselves if they are workers.
+        LockFreeQueue,
+    };
+
+    // How `ThreadPool::ParallelFor` cuts its range into chunks.
+    enum class Partition {
+        // One equal chunk per runner. Least overhead, for bodies that cost the same on every index.
+        Static,
+        // Each chunk takes a share of what is left, shrinking down to the grain, so uneven bodies still finish together.
+        Guided,
+        // Fixed chunks of about a quarter of a runner's share, so a slow chunk can be balanced by the others.
+        Auto,
+    };
+
+    // How `ThreadPool::TransformReduce` and `ThreadPool::Reduce` combine partial results.
+    enum class ReduceOrder {
+        // One partial per fixed chunk of `grain` indices, combined left to right. The result only depends on the range and
+        // the grain, not on the number of threads or on which thread ran which chunk, so floating-point sums repeat exactly.
+        Deterministic,
+        // One partial per runner, combined in runner order. Fewer partials, but chunks go to whichever runner claims them,
+        // so only exact operations (integer sums, min, max) give the same result on every run.
+        Unordered,
+    };
+
+    // Half-open range of indices handed to a `ParallelFor` body.
+    struct IndexRange {
+        int Begin;
+        int End;
+
+        int Size() const { return End - Begin; }
+    };
+
+    // Shared by the caller and the runners of one `ParallelFor`; runners may outlive the call.
+    class ParallelForState {
+        private:
+            std::atomic<int> next;
+            int end;
+            int grain;
+            int chunkSize;       // 0 for guided chunks.
+            int guidedDivisor;
+            std::mutex errorMutex;
+            std::exception_ptr error;
+
+        public:
+            // Counts indices still to run; the caller waits on it.
+            std::latch Remaining;
+
+            ParallelForState(int begin, int end, int grain, int chunkSize, int guidedDivisor)
+                : next(begin), end(end), grain(grain), chunkSize(chunkSize), guidedDivisor(guidedDivisor), Remaining(end - begin) { }
+
+            // Takes the next chunk. Returns false once the whole range has been handed out.
+            bool Claim(IndexRange& range) {
+                int first = next.load(std::memory_order_relaxed);
+                while (first < end) {
+                    int size = chunkSize > 0 ? chunkSize : std::max(grain, (end - first) / guidedDivisor);
+                    int last = end - first > size ? first + size : end;
+                    if (next.compare_exchange_weak(first, last, std::memory_order_relaxed)) {
+                        range = {first, last};
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Keeps the first exception thrown by a chunk, for the caller to rethrow.
+            void SetError(std::exception_ptr e) {
+                std::lock_guard _(errorMutex);
+                if (!error) error = e;
+            }
+
+            void RethrowError() {
+                if (error) std::rethrow_exception(error);
+            }
+    };
+
+    // Completion counter for a group of tasks posted with `ThreadPool::Post(batch, ...)`. `Wait` returns as soon as the
+    // tasks of this batch are done, whatever else the pool is running, and the last task wakes only this batch's waiters.
+    // Copies refer to the same batch, and a batch may be destroyed while its tasks still run.
+    class TaskBatch {
+        private:
+            friend class ThreadPool;
+
+            struct State {
+                std::atomic<int> pending {0};
+                std::mutex errorMutex;
+                std::exception_ptr error;
+            };
+            std::shared_ptr<State> state;
+
+        public:
+            TaskBatch();
+
+            // Blocks until every task posted to the batch so far has finished. Rethrows the first exception thrown by one
+            // of them, once. Waiting from a task of the same pool holds that worker for as long as the wait lasts.
+            void Wait();
+            // Returns whether every task posted to the batch so far has finished.
+            bool IsDone() const;
+            // Returns the number of tasks of the batch that have not finished yet.
+            int GetPending() const;
+    };
+
     class TaskGroupFuture {
         private:
             friend class ThreadPool;
@@ -32,8 +155,8 @@ namespace ll {
 
     class ThreadPool {
         public:
-            // Constructs ThreadPool with specified thread number.
-            explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency());
+            // Constructs ThreadPool with specified thread number, scheduler and worker placement.
+            explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency(), Scheduler scheduler = Scheduler::SharedQueue, const Placement& placement = {});
 
             ThreadPool(const ThreadPool&) = delete;
             ThreadPool(ThreadPool &&) = delete;
@@ -44,20 +167,40 @@ namespace ll {
             ~ThreadPool();
 
         private:
-            using Task = std::function<void()>;
-
             std::vector<std::jthread> threads;
-            std::queue<Task> tasks;
-            std::condition_variable cv, doneCV;
-            mutable std::mutex queueMutex, workerMutex, doneMutex;
-            bool stopped;
-            bool paused;
-            bool* workflags;
+            RingQueue<Task> tasks;
+            std::condition_variable cv;
+            mutable std::mutex queueMutex, workerMutex;
+            std::atomic<bool> stopped;
+            std::atomic<bool> paused;
             std::unordered_map<std::thread::id, int> idMap;
+            std::vector<int> workerCpus;
+
+            // Work stealing: `tasks` is the injection queue. Queued counts tasks in any queue, unfinished also the running ones;
+            // `WaitUntilEmpty` waits on the latter.
+            Scheduler scheduler;
+            std::vector<std::unique_ptr<WorkStealingDeque<Task*>>> deques;
+            std::atomic<long> queuedTasks {0};
+            std::atomic<long> injectedTasks {0};
+            std::atomic<long> unfinishedTasks {0};
+            std::atomic<int> busyWorkers {0};
+            std::atomic<int> sleepingWorkers {0};
+
+            // Lock-free queue, and the counter idle workers wait on; bumped to wake them.
+            static constexpr size_t lockFreeCapacity = 1 << 16;
+            std::unique_ptr<MpmcQueue<Task>> ring;
+            std::atomic<uint32_t> wakeups {0};
 
             void WorkerFunc(int tid);
-
-            bool AllThreadsDone();
+            void LockFreeWorkerFunc(int tid);
+            Task* FindTask(int tid, uint32_t& victimSeed);
+            bool RunRingTask(Task& task);
+            void FinishTask();
+            void WakeWorkers(bool all);
+            void PushTask(Task&& task);
+            long DrainQueues();
+
+            bool NoQueuedTasks() const;
             void Start();
             void JoinThreads();
             void Stop();
@@ -71,38 +214,65 @@ namespace ll {
             // Removes all queued tasks. Any currently executing task will not be affected.
             void Clear();
             // Blocks the caller thread until all tasks finish executing (either the queue is emptied or the pool gets paused).
+            // This waits for every task of every caller; use a `TaskBatch` to wait for just your own.
             void WaitUntilEmpty();
             // Returns the number of remaining tasks in the queue.
             unsigned int GetRemainingTasks() const;
             // Returns the index in the internal list of threads of the caller thread.
             // Will return `-1` if caller thread is not managed by the pool.
             int GetThreadIndex() const;
+            // Returns the number of worker threads.
+            size_t GetThreadCount() const { return threads.size(); }
+            // Most runners a `ParallelFor` started from this thread uses: every worker, plus the caller when it is not one.
+            // Per-runner contexts should be this many.
+            size_t GetMaxRunners() const { return threads.size() + (GetThreadIndex() < 0 ? 1 : 0); }
+
+            // Pins the workers as `placement` says, or unpins them with `PinPolicy::None`. Can be called at any time.
+            void SetPlacement(const Placement& placement);
+            // Returns the CPU worker `worker` is pinned to, or -1 if it is not pinned.
+            int GetWorkerCpu(int worker) const { return workerCpus[worker]; }
+            // Returns the NUMA node worker `worker` is pinned to, or -1 if it is not pinned.
+            int GetWorkerNode(int worker) const { return workerCpus[worker] < 0 ? -1 : CpuTopology::Get().NodeOf(workerCpus[worker]); }
+
+            // Runs `func(worker)` once on every worker, for per-worker setup: with pinned workers, memory a worker allocates and
+            // first writes there lands on its NUMA node. Every worker must become free, so this must not be called from a task.
+            template <class F>
+            requires std::invocable<const F&, int>
+            void RunOnEachWorker(const F& func) {
+                // No worker can take a second task before every worker has taken one.
+                std::latch started(threads.size());
+                TaskBatch batch;
+                for (size_t i = 0; i < threads.size(); i++) {
+                    Post(batch, [this, &func, &started] {
+                        started.arrive_and_wait();
+                        func(GetThreadIndex());
+                    });
+                }
+                batch.Wait();
+            }
 
             // Submits a task to be executed (a function object and optional parameters) and returns an `std::future`.
-            // Parameters to the task will be passed by copy. Consider using a reference capture if this is not acceptable.
+            // The function and parameters are moved or copied into the task. Consider using a reference capture if a copy is not acceptable.
+            // Small tasks do not allocate: the task is stored inline and the promise state comes from a `BlockPool`.
             template <class F, class... Args>
-            requires std::invocable<F, Args...>
-            auto Submit(const F& func, Args&&... args) -> std::future<decltype(func(args...))> {
-                using Res = decltype(func(args...));
-                auto taskPromise = std::make_shared<std::promise<Res>>();
-                auto future = taskPromise->get_future();
-
-                auto taskFunc = [&func, args...] () {
-                    return func(args...);
-                };
+            requires (!std::is_member_pointer_v<std::decay_t<F>>) && std::invocable<std::decay_t<F>&, std::decay_t<Args>&...>
+            auto Submit(F&& func, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>> {
+                using Res = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+                std::promise<Res> taskPromise(std::allocator_arg, PoolAllocator<Res>());
+                auto future = taskPromise.get_future();
 
-                Push([taskFunc, taskPromise] {
+                PushTask([func = std::forward<F>(func), ...args = std::forward<Args>(args), taskPromise = std::move(taskPromise)] () mutable {
                     try {
                         if constexpr (std::is_void_v<Res>) {
-                            taskFunc();
-                            taskPromise->set_value();
+                            std::invoke(func, args...);
+                            taskPromise.set_value();
                         } else {
-                            taskPromise->set_value(taskFunc());
+                            taskPromise.set_value(std::invoke(func, args...));
                         }
                     }
                     catch (...) {
                         try {
-                            taskPromise->set_exception(std::current_exception());
+                            taskPromise.set_exception(std::current_exception());
                         }
                         catch (...) { }
                     }
@@ -110,32 +280,35 @@ namespace ll {
                 return future;
             }
 
+            // Submits a task without a future, for callers that track its completion themselves.
+            template <class F, class... Args>
+            requires (!std::is_member_pointer_v<std::decay_t<F>>) && std::invocable<std::decay_t<F>&, std::decay_t<Args>&...>
+            void Post(F&& func, Args&&... args) {
+                if constexpr (sizeof...(Args) == 0) {
+                    PushTask(Task(std::forward<F>(func)));
+                } else {
+                    PushTask([func = std::forward<F>(func), ...args = std::forward<Args>(args)] () mutable {
+                        std::invoke(func, args...);
+                    });
+                }
+            }
 
-            // Submits a task to be executed (a function object) and returns an `std::future`.
-            template <class F>
-            requires std::invocable<F>
-            auto Submit(const F& func) -> std::future<decltype(func())> {
-                using Res = decltype(func());
-                auto taskPromise = std::make_shared<std::promise<Res>>();
-                auto future = taskPromise->get_future();
+            // Submits a task to `batch`, which counts it until it finishes. An exception thrown by the task is kept for `batch.Wait()`.
+            template <class F, class... Args>
+            requires (!std::is_member_pointer_v<std::decay_t<F>>) && std::invocable<std::decay_t<F>&, std::decay_t<Args>&...>
+            void Post(TaskBatch& batch, F&& func, Args&&... args) {
+                batch.state->pending.fetch_add(1, std::memory_order_relaxed);
 
-                Push([taskFunc = func, taskPromise] {
+                PushTask([state = batch.state, func = std::forward<F>(func), ...args = std::forward<Args>(args)] () mutable {
                     try {
-                        if constexpr (std::is_void_v<Res>) {
-                            taskFunc();
-                            taskPromise->set_value();
-                        } else {
-                            taskPromise->set_value(taskFunc());
-                        }
+                        std::invoke(func, args...);
                     }
                     catch (...) {
-                        try {
-                            taskPromise->set_exception(std::current_exception());
-                        }
-                        catch (...) { }
+                        std::lock_guard _(state->errorMutex);
+                        if (!state->error) state->error = std::current_exception();
                     }
+                    if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) state->pending.notify_all();
                 });
-                return future;
             }
 
             // Submit a member function call as a task. Returns an `std::future` with the corresponding return type.
@@ -150,6 +323,88 @@ namespace ll {
                 });
             }
 
+            // Runs `func(range)` over chunks of [begin, end), each at least `grain` indices long, and returns once all are done.
+            // The caller runs chunks too, and the whole call submits at most one task per thread and does not allocate.
+            template <class F>
+            requires std::invocable<const F&, IndexRange>
+            void ParallelFor(int begin, int end, int grain, const F& func, Partition partition = Partition::Auto) {
+                RunPartitioned(begin, end, grain, partition, threads.size() + 1, [&func] (IndexRange range, int) {
+                    func(range);
+                });
+            }
+
+            // Like `ParallelFor` above, running `func(range, context)` with one element of `contexts` per runner: chunks that
+            // run one after another on the same runner reuse its context (scratch buffers, accumulators).
+            // At most `contexts.size()` runners are used.
+            template <std::ranges::random_access_range Contexts, class F>
+            requires std::invocable<const F&, IndexRange, std::ranges::range_reference_t<Contexts>>
+            void ParallelFor(int begin, int end, int grain, Contexts& contexts, const F& func, Partition partition = Partition::Auto) {
+                RunPartitioned(begin, end, grain, partition, std::ranges::size(contexts), [&func, &contexts] (IndexRange range, int runner) {
+                    func(range, std::ranges::begin(contexts)[runner]);
+                });
+            }
+
+            // Combines `transform(i)` for every `i` in [begin, end) with `reduce`, starting from `init`, and returns the result.
+            // `reduce(a, b)` must be associative, but needs no identity: each chunk starts from its first element.
+            template <class T, class R, class F>
+            requires std::invocable<const F&, int> && std::convertible_to<std::invoke_result_t<const F&, int>, T> && std::invocable<const R&, T, T>
+            T TransformReduce(int begin, int end, int grain, T init, const R& reduce, const F& transform, ReduceOrder order = ReduceOrder::Deterministic) {
+                if (begin >= end) return init;
+                grain = std::max(grain, 1);
+
+                auto fold = [&reduce, &transform] (IndexRange range) {
+                    T acc = transform(range.Begin);
+                    for (int i = range.Begin + 1; i < range.End; i++) acc = reduce(std::move(acc), transform(i));
+                    return acc;
+                };
+
+                std::vector<std::optional<T>> partials;
+                if (order == ReduceOrder::Deterministic) {
+                    int chunks = (end - begin + grain - 1) / grain;
+                    partials.resize(chunks);
+                    ParallelFor(0, chunks, 1, [&] (IndexRange range) {
+                        for (int c = range.Begin; c < range.End; c++) {
+                            partials[c] = fold({begin + c * grain, std::min(end, begin + (c + 1) * grain)});
+                        }
+                    });
+                }
+                else {
+                    partials.resize(GetMaxRunners());
+                    ParallelFor(begin, end, grain, partials, [&] (IndexRange range, std::optional<T>& partial) {
+                        T acc = fold(range);
+                        partial = partial ? reduce(std::move(*partial), std::move(acc)) : std::move(acc);
+                    });
+                }
+
+                for (auto& partial : partials) {
+                    if (partial) init = reduce(std::move(init), std::move(*partial));
+                }
+                return init;
+            }
+
+            // Combines the elements of `values` with `reduce`, starting from `init`. See `TransformReduce`.
+            template <std::ranges::random_access_range V, class T, class R>
+            T Reduce(const V& values, int grain, T init, const R& reduce, ReduceOrder order = ReduceOrder::Deterministic) {
+                auto first = std::ranges::begin(values);
+                return TransformReduce(0, (int) std::ranges::size(values), grain, std::move(init), reduce, [first] (int i) -> decltype(auto) {
+                    return first[i];
+                }, order);
+            }
+
+            // Writes to `output[i]` the combination with `op` of `input[0]` to `input[i]`. `output` may be `input`.
+            // Works on fixed chunks of `grain` elements, so like a deterministic `Reduce` the result does not depend on threads.
+            template <std::ranges::random_access_range In, std::ranges::random_access_range Out, class Op>
+            void InclusiveScan(const In& input, Out&& output, int grain, const Op& op) {
+                RunScan(input, output, grain, std::optional<std::ranges::range_value_t<In>>(), op);
+            }
+
+            // Writes to `output[i]` the combination with `op` of `init` and `input[0]` to `input[i - 1]`, so `output[0]` is `init`.
+            // Turns flags into destination indices for compaction. `output` may be `input`.
+            template <std::ranges::random_access_range In, std::ranges::random_access_range Out, class T, class Op>
+            void ExclusiveScan(const In& input, Out&& output, int grain, T init, const Op& op) {
+                RunScan(input, output, grain, std::optional<T>(std::move(init)), op);
+            }
+
             // Executes a for loop in parallel. Runs task as `func(i)` where `i` is of type `int` and goes from [min, max).
             // The task is required to take a single argument of type `int`.
             template <class F>
@@ -281,27 +536,93 @@ namespace ll {
             }
 
         private:
-            template <class F, class... Args>
-            requires std::invocable<F, Args...> && requires (F f, Args... args) {
-                {f(args...)} -> std::same_as<void>;
+            // Two passes over chunks of `grain` elements: the first totals every chunk but the last, the caller turns the totals
+            // into the value each chunk starts from, and the second rescans each chunk from it. An exclusive scan has an `init`.
+            template <class In, class Out, class T, class Op>
+            void RunScan(const In& input, Out& output, int grain, std::optional<T> init, const Op& op) {
+                int count = std::ranges::size(input);
+                if (count == 0) return;
+                grain = std::max(grain, 1);
+                int chunks = (count + grain - 1) / grain;
+                bool exclusive = init.has_value();
+
+                auto in = std::ranges::begin(input);
+                auto out = std::ranges::begin(output);
+
+                std::vector<std::optional<T>> starts(chunks);
+                ParallelFor(0, chunks - 1, 1, [&] (IndexRange range) {
+                    for (int c = range.Begin; c < range.End; c++) {
+                        int last = std::min(count, (c + 1) * grain);
+                        T acc = in[c * grain];
+                        for (int i = c * grain + 1; i < last; i++) acc = op(std::move(acc), in[i]);
+                        starts[c + 1] = std::move(acc);
+                    }
+                });
+
+                starts[0] = std::move(init);
+                for (int c = 1; c < chunks; c++) {
+                    if (starts[c - 1]) starts[c] = op(*starts[c - 1], std::move(*starts[c]));
+                }
+
+                ParallelFor(0, chunks, 1, [&] (IndexRange range) {
+                    for (int c = range.Begin; c < range.End; c++) {
+                        int last = std::min(count, (c + 1) * grain);
+                        std::optional<T> acc = std::move(starts[c]);
+                        for (int i = c * grain; i < last; i++) {
+                            // Read before writing, for scans in place.
+                            std::ranges::range_value_t<In> value = in[i];
+                            if (exclusive) {
+                                out[i] = *acc;
+                                acc = op(std::move(*acc), std::move(value));
+                            }
+                            else {
+                                acc = acc ? op(std::move(*acc), std::move(value)) : T(std::move(value));
+                                out[i] = *acc;
+                            }
+                        }
+                    }
+                });
             }
-            void Push(const F& func, Args&&... args) {
-                std::lock_guard lock(queueMutex);
-                auto f = [func, args...] {
-                    func(args...);
+
+            // Runner 0 is the caller; runners 1 and up are tasks, which may start after the range is done and then just exit.
+            // A caller from outside the pool runs next to every worker, a worker calling in takes the place of one.
+            // `body` is only touched while a chunk is claimed, and the caller cannot return before every claimed chunk ends.
+            template <class B>
+            void RunPartitioned(int begin, int end, int grain, Partition partition, size_t maxRunners, const B& body) {
+                if (begin >= end) return;
+
+                grain = std::max(grain, 1);
+                int count = end - begin;
+                int runners = (int) std::min({GetMaxRunners(), std::max<size_t>(maxRunners, 1), (size_t) (count + grain - 1) / grain});
+
+                int chunkSize = 0;
+                if (partition == Partition::Static) chunkSize = std::max(grain, (count + runners - 1) / runners);
+                if (partition == Partition::Auto) chunkSize = std::max(grain, (count + 4 * runners - 1) / (4 * runners));
+
+                auto state = std::allocate_shared<ParallelForState>(PoolAllocator<ParallelForState>(), begin, end, grain, chunkSize, 2 * runners);
+
+                auto run = [state, &body] (int runner) {
+                    IndexRange range;
+                    while (state->Claim(range)) {
+                        try {
+                            body(range, runner);
+                        }
+                        catch (...) {
+                            state->SetError(std::current_exception());
+                        }
+                        state->Remaining.count_down(range.Size());
+                    }
                 };
-                tasks.push(f);
-                cv.notify_one();
-            }
 
-            template <class F>
-            requires std::invocable<F> && requires (F f) {
-                {f()} -> std::same_as<void>;
-            }
-            void Push(const F& func) {
-                std::lock_guard lock(queueMutex);
-                tasks.push(func);
-                cv.notify_one();
+                for (int r = 1; r < runners; r++) {
+                    PushTask([run, r] {
+                        run(r);
+                    });
+                }
+                run(0);
+
+                state->Remaining.wait();
+                state->RethrowError();
             }
     };
 
@@ -0,0 +1,173 @@
+#include "Topology.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define LL_LINUX_AFFINITY
+#endif
+
+using namespace ll;
+
+// Reads the single integer in a sysfs file, or returns `fallback`.
+static int ReadSysInt(const std::string& path, int fallback) {
+    std::ifstream file {path};
+    int value;
+    return file >> value ? value : fallback;
+}
+
+std::vector<int> ll::ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream {list};
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty() || item == "\n") continue;
+        int first = std::stoi(item);
+        auto dash = item.find('-');
+        int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+#ifdef LL_LINUX_AFFINITY
+// The mask the process started with, which unpinned workers get back.
+static const cpu_set_t& ProcessCpus() {
+    static const cpu_set_t mask = [] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+            for (int cpu = 0; cpu < (int) std::thread::hardware_concurrency(); cpu++) CPU_SET(cpu, &set);
+        }
+        return set;
+    }();
+    return mask;
+}
+#endif
+
+const CpuTopology& CpuTopology::Get() {
+    static const CpuTopology topology = [] {
+        CpuTopology result;
+
+#ifdef LL_LINUX_AFFINITY
+        std::map<int, int> nodeOfCpu;
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+            std::string name = entry.path().filename();
+            if (!name.starts_with("node") || name.size() == 4 || !std::isdigit((unsigned char) name[4])) continue;
+
+            std::ifstream file {entry.path() / "cpulist"};
+            std::string list;
+            std::getline(file, list);
+            for (int cpu : ParseCpuList(list)) nodeOfCpu[cpu] = std::stoi(name.substr(4));
+        }
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &ProcessCpus())) continue;
+
+            std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            int core = ReadSysInt(topology + "core_id", cpu);
+            int package = ReadSysInt(topology + "physical_package_id", 0);
+            result.Cpus.push_back({cpu, core, std::max(package, 0), nodeOfCpu.contains(cpu) ? nodeOfCpu[cpu] : 0});
+        }
+#endif
+
+        if (result.Cpus.empty()) {
+            for (int cpu = 0; cpu < (int) std::max(1u, std::thread::hardware_concurrency()); cpu++) result.Cpus.push_back({cpu, cpu, 0, 0});
+        }
+
+        std::set<int> nodes;
+        for (auto& cpu : result.Cpus) nodes.insert(cpu.Node);
+        result.NumNodes = nodes.size();
+        return result;
+    }();
+    return topology;
+}
+
+int CpuTopology::NodeOf(int cpu) const {
+    for (auto& info : Cpus) {
+        if (info.Id == cpu) return info.Node;
+    }
+    return -1;
+}
+
+std::vector<int> CpuTopology::CompactOrder() const {
+    std::vector<CpuInfo> sorted = Cpus;
+    std::ranges::sort(sorted, {}, [] (const CpuInfo& c) { return std::tuple(c.Node, c.Package, c.Core, c.Id); });
+
+    std::vector<int> order;
+    for (auto& cpu : sorted) order.push_back(cpu.Id);
+    return order;
+}
+
+std::vector<int> CpuTopology::ScatterOrder() const {
+    // Rank of each CPU among the hardware threads of its core: every rank 0 goes before any rank 1.
+    std::map<std::tuple<int, int>, int> threadsSeen;
+    std::map<int, std::vector<std::tuple<int, int, int, int>>> byNode;
+    for (auto& cpu : CompactOrder()) {
+        auto& info = *std::ranges::find(Cpus, cpu, &CpuInfo::Id);
+        int rank = threadsSeen[{info.Package, info.Core}]++;
+        byNode[info.Node].push_back({rank, info.Package, info.Core, info.Id});
+    }
+    for (auto& [node, cpus] : byNode) std::ranges::sort(cpus);
+
+    std::vector<int> order;
+    for (size_t i = 0; order.size() < Cpus.size(); i++) {
+        for (auto& [node, cpus] : byNode) {
+            if (i < cpus.size()) order.push_back(std::get<3>(cpus[i]));
+        }
+    }
+    return order;
+}
+
+std::vector<int> Placement::WorkerCpus(size_t numWorkers) const {
+    const CpuTopology& topology = CpuTopology::Get();
+    std::vector<int> order;
+
+    switch (Policy) {
+        case PinPolicy::None:
+            break;
+        case PinPolicy::Compact:
+            order = topology.CompactOrder();
+            break;
+        case PinPolicy::Scatter:
+            order = topology.ScatterOrder();
+            break;
+        case PinPolicy::List:
+            for (int cpu : CpuList) {
+                if (topology.NodeOf(cpu) < 0) throw std::invalid_argument("Tried to pin a ThreadPool worker to CPU " + std::to_string(cpu) + ", which the process cannot run on.");
+            }
+            order = CpuList;
+            break;
+    }
+
+    std::vector<int> cpus(numWorkers, -1);
+    if (order.empty()) return cpus;
+    for (size_t i = 0; i < numWorkers; i++) cpus[i] = order[i % order.size()];
+    return cpus;
+}
+
+bool ll::PinThread(std::jthread& thread, int cpu) {
+#ifdef LL_LINUX_AFFINITY
+    if (cpu >= CPU_SETSIZE) return false;
+
+    cpu_set_t set = ProcessCpus();
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    return cpu < 0;
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ll {
+    // A logical CPU the process may run on, numbered as the kernel does.
+    struct CpuInfo {
+        int Id;
+        int Core;       // Unique within its package; hardware threads of one core share it.
+        int Package;    // Socket.
+        int Node;       // NUMA node.
+    };
+
+    // CPUs and NUMA nodes, read once from `/sys/devices/system`. Only CPUs that are online and in the affinity mask the
+    // process started with are listed. Without that information (other systems), every CPU is its own core on node 0.
+    class CpuTopology {
+        public:
+            std::vector<CpuInfo> Cpus;
+            int NumNodes = 1;
+
+            static const CpuTopology& Get();
+
+            // Returns the node of `cpu`, or -1 if it is not listed.
+            int NodeOf(int cpu) const;
+            // Node by node, core by core, with the hardware threads of a core next to each other.
+            std::vector<int> CompactOrder() const;
+            // One CPU per node in turn, and within a node every core once before any second hardware thread.
+            std::vector<int> ScatterOrder() const;
+    };
+
+    // Which CPUs the workers of a ThreadPool run on.
+    enum class PinPolicy {
+        // Let the OS schedule and migrate the workers.
+        None,
+        // Fill one node before the next, so the workers share caches and memory.
+        Compact,
+        // Spread over nodes and cores, for the most cache and memory bandwidth.
+        Scatter,
+        // Worker `i` runs on `CpuList[i % CpuList.size()]`.
+        List,
+    };
+
+    struct Placement {
+        PinPolicy Policy;
+        std::vector<int> CpuList;
+
+        Placement(PinPolicy policy = PinPolicy::None, std::vector<int> cpuList = {}) : Policy(policy), CpuList(std::move(cpuList)) { }
+
+        // Returns the CPU of each of `numWorkers` workers, -1 for unpinned ones.
+        // Throws `std::invalid_argument` if the list names a CPU the process cannot run on.
+        std::vector<int> WorkerCpus(size_t numWorkers) const;
+    };
+
+    // Parses a CPU list in the sysfs format, like "0-3,8-11".
+    std::vector<int> ParseCpuList(const std::string& list);
+
+    // Restricts `thread` to `cpu`, or with -1 gives it back every CPU of the process. Returns false if that failed.
+    bool PinThread(std::jthread& thread, int cpu);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace ll {
+    // Chase–Lev work-stealing deque of pointers, with the C11 memory orderings of Lê et al.,
+    // "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+    // Only the owner thread may call `Push` and `Pop` (at the bottom); any thread may call `Steal` (at the top).
+    template <class T>
+    requires std::is_pointer_v<T>
+    class WorkStealingDeque {
+        private:
+            struct Buffer {
+                int64_t capacity;
+                std::unique_ptr<std::atomic<T>[]> slots;
+
+                explicit Buffer(int64_t capacity) : capacity(capacity), slots(new std::atomic<T>[capacity]) { }
+
+                T Get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+                void Put(int64_t i, T value) { slots[i & (capacity - 1)].store(value, std::memory_order_relaxed); }
+            };
+
+            alignas(64) std::atomic<int64_t> top {0};
+            alignas(64) std::atomic<int64_t> bottom {0};
+            std::atomic<Buffer*> buffer;
+
+            // Outgrown buffers stay alive until the deque dies, since a thief may still be reading one.
+            std::vector<std::unique_ptr<Buffer>> buffers;
+
+            Buffer* Grow(Buffer* old, int64_t t, int64_t b) {
+                auto grown = std::make_unique<Buffer>(old->capacity * 2);
+                for (int64_t i = t; i < b; i++) grown->Put(i, old->Get(i));
+
+                Buffer* result = grown.get();
+                buffers.push_back(std::move(grown));
+                buffer.store(result, std::memory_order_release);
+                return result;
+            }
+
+        public:
+            // Capacity must be a power of two; the deque doubles it when full.
+            explicit WorkStealingDeque(int64_t capacity = 256) {
+                buffers.push_back(std::make_unique<Buffer>(capacity));
+                buffer.store(buffers.back().get(), std::memory_order_relaxed);
+            }
+
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+            WorkStealingDeque& operator= (const WorkStealingDeque&) = delete;
+
+            // Owner only.
+            void Push(T value) {
+                int64_t b = bottom.load(std::memory_order_relaxed);
+                int64_t t = top.load(std::memory_order_acquire);
+                Buffer* a = buffer.load(std::memory_order_relaxed);
+
+                if (b - t > a->capacity - 1) a = Grow(a, t, b);
+                a->Put(b, value);
+                // A release store rather than the paper's release fence: same code on x86, and visible to ThreadSanitizer.
+                bottom.store(b + 1, std::memory_order_release);
+            }
+
+            // Owner only. Returns the most recently pushed element, or `nullptr` when empty.
+            T Pop() {
+                int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+                Buffer* a = buffer.load(std::memory_order_relaxed);
+                bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t t = top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                T value = a->Get(b);
+                if (t == b) {
+                    // Last element: race the thieves for it.
+                    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) value = nullptr;
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                }
+                return value;
+            }
+
+            // Any thread. Returns the oldest element, or `nullptr` when empty or when another thread took it first.
+            T Steal() {
+                int64_t t = top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t b = bottom.load(std::memory_order_acquire);
+
+                if (t >= b) return nullptr;
+
+                T value = buffer.load(std::memory_order_acquire)->Get(t);
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+                return value;
+            }
+
+            // Approximate when other threads are pushing or stealing.
+            int64_t Size() const {
+                int64_t b = bottom.load(std::memory_order_relaxed);
+                int64_t t = top.load(std::memory_order_relaxed);
+                return b > t ? b - t : 0;
+            }
+    };
+}
@@ -0,0 +1,108 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "Distillation.hpp"
+#include "Scenario.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+static constexpr uint32_t DistillTrainSeed = 1234;
+static constexpr uint32_t DistillEvalSeed = 98765;
+static constexpr int DistillTrainScenarios = 300;
+static constexpr int DistillEvalScenarios = 100;
+static constexpr int DistillBatchSize = 64;
+static constexpr int DistillDaggerRounds = 3;
+static constexpr FP DistillLearningRate = 3e-3;
+
+int DistillTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    int hidden1 = ToolArgInt(args, 1, 6);
+    int hidden2 = ToolArgInt(args, 2, 4);
+    const char* outName = ToolArg(args, 3, "distilled.gen");
+    int epochs = ToolArgInt(args, 4, 60);
+
+    Drone teacher;
+    if (!LoadCheckpointBest(fileName, teacher)) return 1;
+
+    auto teacherPilot = [&teacher] (const std::array<FP, InputSize>& input) {
+        return teacher.Brain.EvaluateNetwork(input);
+    };
+
+    StudentNetwork student(hidden1, hidden2, DistillTrainSeed);
+    auto studentPilot = [&student] (const std::array<FP, InputSize>& input) {
+        return student.EvaluateNetwork(input);
+    };
+
+    auto trainScenarios = GenerateScenarios(DistillTrainScenarios, DistillTrainSeed);
+
+    std::vector<StudentNetwork::Sample> samples;
+    CollectDistillationSamples(teacher.Brain, teacherPilot, trainScenarios, samples);
+
+    std::cout << "Student " << InputSize << "-" << hidden1 << "-" << hidden2 << "-" << OutputSize;
+    std::cout << " (" << student.GetGenome().size() << " parameters, teacher " << ControlNetwork::GenomeSize << ")\n";
+    std::cout << "Collected " << samples.size() << " teacher states from " << DistillTrainScenarios << " scenarios.\n";
+
+    std::mt19937 gen {DistillTrainSeed};
+
+    for (int round = 0; round <= DistillDaggerRounds; round++) {
+        // After the first round, add the states the student itself visits, labeled by the teacher.
+        if (round > 0) CollectDistillationSamples(teacher.Brain, studentPilot, trainScenarios, samples);
+
+        FP loss = 0.0;
+        for (int epoch = 0; epoch < epochs; epoch++) {
+            std::shuffle(samples.begin(), samples.end(), gen);
+
+            FP rate = DistillLearningRate * (1.0 - 0.9 * epoch / std::max(epochs - 1, 1));
+
+            loss = 0.0;
+            int batches = 0;
+            for (size_t first = 0; first < samples.size(); first += DistillBatchSize) {
+                size_t n = std::min<size_t>(DistillBatchSize, samples.size() - first);
+                loss += student.TrainStep(std::span(samples.data() + first, n), rate);
+                batches++;
+            }
+            loss /= batches;
+        }
+
+        std::cout << "Round " << round << ": " << samples.size() << " samples, final epoch loss " << loss << "\n";
+    }
+
+    FP teacherPenalty = 0.0;
+    FP studentPenalty = 0.0;
+    FP meanDeviation = 0.0;
+    FP maxDeviation = 0.0;
+    int deviationSamples = 0;
+
+    Drone flyer {ControlNetwork(ControlNetwork::InitMode::Zeroes)};
+    for (auto& scenario : GenerateScenarios(DistillEvalScenarios, DistillEvalSeed)) {
+        auto teacherFlight = FlyScenario(flyer, scenario, teacherPilot, true);
+        auto studentFlight = FlyScenario(flyer, scenario, studentPilot, true);
+
+        teacherPenalty += teacherFlight.Penalty / DistillEvalScenarios;
+        studentPenalty += studentFlight.Penalty / DistillEvalScenarios;
+
+        for (int i = 0; i < teacherFlight.Steps; i++) {
+            FP deviation = (teacherFlight.Trajectory[i] - studentFlight.Trajectory[i]).Mag();
+            meanDeviation += deviation;
+            maxDeviation = std::max(maxDeviation, deviation);
+            deviationSamples++;
+        }
+    }
+    meanDeviation /= deviationSamples;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "\nClosed loop over " << DistillEvalScenarios << " held-out scenarios:\n";
+    std::cout << "    teacher mean penalty: " << teacherPenalty << "\n";
+    std::cout << "    student mean penalty: " << studentPenalty << "\n";
+    std::cout << "    trajectory deviation: mean " << meanDeviation << ", max " << maxDeviation << "\n";
+
+    if (!student.SaveCheckpoint(outName, 0)) {
+        std::cerr << "Could not write '" << outName << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << "\nWrote " << outName << ", loadable with Hidden1Size = " << hidden1 << " and Hidden2Size = " << hidden2 << "." << std::endl;
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "ControllerExport.hpp"
+
+int ExportTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    const char* name = ToolArg(args, 1, "DroneController");
+    const char* directory = ToolArg(args, 2, ".");
+
+    Drone drone;
+    if (!LoadCheckpointBest(fileName, drone)) return 1;
+
+    return ControllerExport::ExportToFiles(drone.Brain, name, directory) ? 0 : 1;
+}
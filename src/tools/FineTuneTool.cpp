@@ -0,0 +1,132 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "DifferentiableSim.hpp"
+#include "Scenario.hpp"
+#include "TrainingSim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+static constexpr uint32_t FineTuneTrainingSeed = 11;
+static constexpr uint32_t FineTuneEvaluationSeed = 3;
+static constexpr int FineTuneGradientChecks = 12;
+static constexpr int FineTuneEpisodeChecks = 8;
+
+// Over whole flights the feedback loop makes most gradients huge and the finite differences ill-conditioned, so the check uses shorter flights.
+static constexpr FP FineTuneCheckHorizon = 1.5;
+static constexpr FP FineTuneIllConditioned = 1e6;
+
+int FineTuneTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    const char* outName = ToolArg(args, 1, "finetuned.gen");
+    int steps = ToolArgInt(args, 2, 100);
+    int numScenarios = ToolArgInt(args, 3, 20);
+
+    TrainingSim training;
+    if (!training.LoadFromFile(fileName)) return 1;
+
+    const ControlNetwork& original = training.Drones[0].Brain;
+    auto genome = original.GetGenome();
+
+    auto trainScenarios = GenerateScenarios(numScenarios, FineTuneTrainingSeed);
+    auto heldOut = GenerateScenarios(200, FineTuneEvaluationSeed);
+    RngKey trainKey {FineTuneTrainingSeed};
+
+    std::cout << std::setprecision(4);
+
+    // The generic-scalar simulation must fly like the training episodes, or its gradient is of a different function.
+    // Both perform the same operations, but the compiler contracts them into FMAs differently, and chaotic flights
+    // amplify that last bit. Compared per drone evaluation, `SimulationsPerDrone` episodes each.
+    int identical = 0;
+    FP maxValueDiff = 0.0;
+    for (int c = 0; c < FineTuneEpisodeChecks; c++) {
+        RngKey key {FineTuneTrainingSeed, 0, (uint32_t) c};
+        auto scenarios = GenerateScenarios(SimulationsPerDrone, FineTuneTrainingSeed + 1 + c);
+
+        FP reference = TrainingSim::EpisodePenalty(original, scenarios, key);
+        FP value = DifferentiableSim::MeanPenalty(genome, scenarios, key);
+        if (value == reference) identical++;
+        maxValueDiff = std::max(maxValueDiff, std::abs(value - reference) / std::max(std::abs(reference), (FP) 1.0));
+    }
+    std::cout << "Differentiable simulation vs training episodes: " << identical << "/" << FineTuneEpisodeChecks << " drone evaluations bit-identical, max relative difference " << maxValueDiff << "\n";
+
+    std::vector<FP> gradient(genome.size());
+    FP penalty = 0.0;
+    double gradientSeconds = MeasureSeconds([&] {
+        penalty = DifferentiableSim::MeanPenaltyGradient(genome, trainScenarios, trainKey, gradient);
+    });
+    std::cout << "Penalty " << penalty << " and its gradient over " << numScenarios << " scenarios in " << gradientSeconds * 1e3 << " ms\n";
+
+    // Central differences per scenario on genes spread over every layer. The thrust rate limiter switches branches
+    // along the flight, so the penalty is only smooth in small cells around the genome and the step has to stay inside
+    // them. In some flights the feedback loop makes the derivative so large that no step resolves it; those are counted apart.
+    int agreeing = 0, illConditioned = 0, checks = 0;
+    std::vector<FP> errors;
+    std::vector<FP> checkGradient(genome.size());
+    std::vector<FP> probe(genome.begin(), genome.end());
+
+    for (auto scenario : trainScenarios) {
+        scenario.TimeLimit = std::min(scenario.TimeLimit, FineTuneCheckHorizon);
+        DifferentiableSim::MeanPenaltyGradient(genome, {scenario}, trainKey, checkGradient);
+
+        for (int c = 0; c < FineTuneGradientChecks; c++) {
+            size_t i = (size_t) c * (genome.size() - 1) / (FineTuneGradientChecks - 1);
+            FP h = 1e-8 * std::max(std::abs(probe[i]), (FP) 1.0);
+            FP saved = probe[i];
+
+            probe[i] = saved + h;
+            FP up = DifferentiableSim::MeanPenalty(probe, {scenario}, trainKey);
+            probe[i] = saved - h;
+            FP down = DifferentiableSim::MeanPenalty(probe, {scenario}, trainKey);
+            probe[i] = saved;
+
+            FP numeric = (up - down) / (2.0 * h);
+            FP error = std::abs(numeric - checkGradient[i]) / std::max(std::abs(numeric) + std::abs(checkGradient[i]), (FP) 1e-9);
+
+            checks++;
+            if (std::abs(checkGradient[i]) > FineTuneIllConditioned) {
+                illConditioned++;
+                continue;
+            }
+            errors.push_back(error);
+            if (error < 1e-4) agreeing++;
+        }
+    }
+
+    std::sort(errors.begin(), errors.end());
+    std::cout << "Gradient check over the first " << FineTuneCheckHorizon << " s of each scenario, " << checks << " genes: ";
+    std::cout << agreeing << " within 1e-4 of finite differences, median relative error " << (errors.empty() ? 0.0 : errors[errors.size() / 2]);
+    std::cout << ", " << illConditioned << " with |gradient| > " << FineTuneIllConditioned << " skipped\n\n";
+
+    FP before = MeanScenarioPenalty(original, heldOut);
+
+    ControlNetwork tuned = original;
+    FP trainPenalty = 0.0;
+    double tuneSeconds = MeasureSeconds([&] {
+        trainPenalty = DifferentiableSim::FineTune(tuned, trainScenarios, trainKey, steps, TrainingFineTuneLearningRate);
+    });
+    FP after = MeanScenarioPenalty(tuned, heldOut);
+
+    std::cout << "Fine-tune, " << steps << " steps in " << tuneSeconds << " s: training penalty " << penalty << " -> " << trainPenalty << "\n";
+    std::cout << "Held-out penalty over " << heldOut.size() << " scenarios: " << before << " -> " << after << "\n";
+
+    // Same wall time spent on the genetic algorithm instead, starting from the same population.
+    TrainingSim ga = training;
+    int generations = 0;
+    double gaSeconds = 0.0;
+    while (gaSeconds < tuneSeconds) {
+        gaSeconds += MeasureSeconds([&] { ga.TrainGeneration(); });
+        generations++;
+    }
+
+    // `TrainGeneration` sorts before breeding, so the first drone is the best of the last evaluated generation.
+    std::cout << "Genetic algorithm, " << generations << " generations in " << gaSeconds << " s: held-out penalty " << MeanScenarioPenalty(ga.Drones[0].Brain, heldOut) << "\n";
+
+    training.Drones[0].Brain = tuned;
+    training.Drones[0].CompiledBrain.reset();
+    training.SaveToFile(outName);
+    std::cout << "Wrote " << outName << "." << std::endl;
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "PhysicsSim.hpp"
+#include "Scenario.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+static constexpr uint32_t HeadingCheckSeed = 3;
+
+// Largest accepted distance between the rotated heading and (cos, sin) of the accumulated angle.
+static constexpr FP HeadingDriftBound = 1e-12;
+
+// Flies `scenario` from rest like the training episodes, with `HeadingStep` or with the separate
+// `UpdateThrust` + `IntegrateState`. Records positions and, on the heading path, the largest heading drift.
+template <bool Incremental>
+static FP HeadingFly(const ControlNetwork& net, const Scenario& scenario, std::vector<Vec2>* trajectory, FP* maxDrift = nullptr) {
+    std::conditional_t<Incremental, HeadingDroneState, DroneState> state;
+    std::array<FP, 2> thrust {};
+
+    for (FP t = 0.0; t < scenario.TimeLimit; t += PhysicsSimDeltaT) {
+        auto out = net.EvaluateNetwork(PhysicsSim::NetworkInputs(state, scenario.Target));
+
+        if constexpr (Incremental) {
+            PhysicsSim::HeadingStep(state, thrust, out[0], out[1], PhysicsSimDeltaT);
+
+            FP drift = std::hypot(state.HeadingCos - std::cos(state.DirectionAngle), state.HeadingSin - std::sin(state.DirectionAngle));
+            *maxDrift = std::max(*maxDrift, drift);
+        }
+        else {
+            PhysicsSim::UpdateThrust(thrust, out[0], out[1], PhysicsSimDeltaT);
+            PhysicsSim::IntegrateState(state, thrust, PhysicsSimDeltaT);
+        }
+
+        if (trajectory) trajectory->push_back(state.Position);
+    }
+
+    return ScenarioPenalty(state, scenario.Target);
+}
+
+int HeadingCheckTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    int numScenarios = ToolArgInt(args, 1, 200);
+
+    Drone drone;
+    if (!LoadCheckpointBest(fileName, drone)) return 1;
+
+    const ControlNetwork& net = drone.Brain;
+    auto scenarios = GenerateScenarios(numScenarios, HeadingCheckSeed);
+
+    // The heading drift is measured along the incremental path itself, so it is not mixed up with trajectory divergence.
+    FP maxDrift = 0.0;
+    std::vector<FP> penaltyDiffs, firstSecondDiffs;
+    std::vector<Vec2> exact, incremental;
+
+    for (auto& scenario : scenarios) {
+        exact.clear();
+        incremental.clear();
+
+        FP exactPenalty = HeadingFly<false>(net, scenario, &exact);
+        FP incrementalPenalty = HeadingFly<true>(net, scenario, &incremental, &maxDrift);
+
+        // Rounding differences grow along the closed loop, chaotically in some flights, so the
+        // trajectories are also compared over their first second alone.
+        FP firstSecond = 0.0;
+        for (size_t i = 0; i < exact.size() && i * PhysicsSimDeltaT < 1.0; i++) {
+            firstSecond = std::max(firstSecond, (exact[i] - incremental[i]).Mag());
+        }
+
+        firstSecondDiffs.push_back(firstSecond);
+        penaltyDiffs.push_back(std::abs(incrementalPenalty - exactPenalty) / std::max(std::abs(exactPenalty), (FP) 1.0));
+    }
+
+    std::sort(penaltyDiffs.begin(), penaltyDiffs.end());
+    std::sort(firstSecondDiffs.begin(), firstSecondDiffs.end());
+
+    std::cout << std::setprecision(3);
+    std::cout << "Heading drift from (cos, sin) of the angle over " << numScenarios << " flights: " << maxDrift << " (bound " << HeadingDriftBound << ")\n";
+    std::cout << "Position difference over the first second: median " << firstSecondDiffs[firstSecondDiffs.size() / 2] << ", max " << firstSecondDiffs.back() << "\n";
+    std::cout << "Relative penalty difference over whole flights: median " << penaltyDiffs[penaltyDiffs.size() / 2] << ", max " << penaltyDiffs.back() << "\n\n";
+
+    // Physics alone, replaying the thrust requests of the flights above, so the network does not dominate the timing.
+    std::vector<std::array<FP, 2>> requests;
+    std::vector<int> flightSteps;
+    for (auto& scenario : scenarios) {
+        PhysicsSim sim(drone);
+        int stepCount = 0;
+        for (FP t = 0.0; t < scenario.TimeLimit; t += PhysicsSimDeltaT, stepCount++) {
+            sim.ControllerStep([&] (const std::array<FP, InputSize>& input) {
+                auto out = net.EvaluateNetwork(input);
+                requests.push_back(out);
+                return out;
+            }, scenario.Target, PhysicsSimDeltaT);
+            sim.DoSimulationStep(PhysicsSimDeltaT);
+        }
+        flightSteps.push_back(stepCount);
+    }
+
+    FP checksum = 0.0;
+    auto replay = [&] <class State> (auto&& step) {
+        size_t next = 0;
+        for (size_t f = 0; f < flightSteps.size(); f++) {
+            State state;
+            std::array<FP, 2> thrust {};
+            for (int i = 0; i < flightSteps[f]; i++, next++) {
+                auto input = PhysicsSim::NetworkInputs(state, scenarios[f].Target);
+                checksum += input[5] + input[6];
+                step(state, thrust, requests[next]);
+            }
+        }
+    };
+
+    constexpr int repeats = 20;
+    double exactSeconds = MeasureSeconds([&] {
+        for (int r = 0; r < repeats; r++) {
+            replay.operator()<DroneState>([] (DroneState& state, std::array<FP, 2>& thrust, const std::array<FP, 2>& request) {
+                PhysicsSim::UpdateThrust(thrust, request[0], request[1], PhysicsSimDeltaT);
+                PhysicsSim::IntegrateState(state, thrust, PhysicsSimDeltaT);
+            });
+        }
+    });
+
+    double headingSeconds = MeasureSeconds([&] {
+        for (int r = 0; r < repeats; r++) {
+            replay.operator()<HeadingDroneState>([] (HeadingDroneState& state, std::array<FP, 2>& thrust, const std::array<FP, 2>& request) {
+                PhysicsSim::HeadingStep(state, thrust, request[0], request[1], PhysicsSimDeltaT);
+            });
+        }
+    });
+
+    double steps = (double) requests.size() * repeats;
+    std::cout << std::setprecision(2) << std::fixed;
+    std::cout << "Inputs + thrust + integration: " << exactSeconds * 1e9 / steps << " ns/step with sin/cos, ";
+    std::cout << headingSeconds * 1e9 / steps << " ns/step with the incremental heading (" << exactSeconds / headingSeconds << "x)\n";
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+
+    return maxDrift <= HeadingDriftBound ? 0 : 1;
+}
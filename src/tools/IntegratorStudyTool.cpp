@@ -0,0 +1,182 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "PhysicsSim.hpp"
+#include "Scenario.hpp"
+#include "TrainingSim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t IntegratorStudySeed = 3;
+
+// The reference integrates every 60 Hz step, with its thrust, in this many RK4 substeps.
+static constexpr int IntegratorReferenceSubsteps = 32;
+
+// Flights are chaotic over their whole length, so positions are also compared this early, where the integration error still shows.
+static constexpr FP IntegratorEarlyTime = 1.0;
+
+struct IntegratorSetup {
+    Integrator Method;
+    FP DeltaT;
+    int ControlInterval;
+    int Substeps = 1;
+};
+
+static const char* IntegratorName(Integrator integrator) {
+    switch (integrator) {
+        case Integrator::SemiImplicitEuler: return "semi-implicit Euler";
+        case Integrator::VelocityVerlet: return "velocity Verlet";
+        case Integrator::RK2: return "RK2";
+        case Integrator::RK4: return "RK4";
+    }
+    return "?";
+}
+
+// Flies `scenario` from rest like `RunTrainingEpisodes` does with `setup`, counting network evaluations and physics steps.
+// `early` gets the position at `IntegratorEarlyTime`.
+static DroneState IntegratorFly(const ControlNetwork& net, const Scenario& scenario, const IntegratorSetup& setup, Vec2& early, long& evaluations, long& steps) {
+    DroneState state;
+    std::array<FP, 2> thrust {};
+    std::array<FP, OutputSize> out {};
+
+    int step = 0;
+    for (FP t = 0.0; t < scenario.TimeLimit; t += setup.DeltaT, step++) {
+        if (step % setup.ControlInterval == 0) {
+            out = net.EvaluateNetwork(PhysicsSim::NetworkInputs(state, scenario.Target));
+            evaluations++;
+        }
+
+        PhysicsSim::UpdateThrust(thrust, out[0], out[1], setup.DeltaT);
+        for (int s = 0; s < setup.Substeps; s++) {
+            PhysicsSim::IntegrateState(state, thrust, setup.DeltaT / setup.Substeps, setup.Method);
+        }
+
+        if (step == (int) std::round(IntegratorEarlyTime / setup.DeltaT) - 1) early = state.Position;
+    }
+
+    steps += (long) step * setup.Substeps;
+    return state;
+}
+
+// Spearman correlation, from the Pearson correlation of the ranks (scores are continuous, so ties are ignored).
+static double RankCorrelation(const std::vector<FP>& a, const std::vector<FP>& b) {
+    auto ranks = [] (const std::vector<FP>& values) {
+        std::vector<int> order(values.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&] (int i, int j) { return values[i] < values[j]; });
+
+        std::vector<double> rank(values.size());
+        for (size_t i = 0; i < order.size(); i++) rank[order[i]] = i;
+        return rank;
+    };
+
+    auto ra = ranks(a), rb = ranks(b);
+    double n = ra.size();
+    double mean = (n - 1) / 2;
+
+    double cov = 0.0, varA = 0.0, varB = 0.0;
+    for (size_t i = 0; i < ra.size(); i++) {
+        cov += (ra[i] - mean) * (rb[i] - mean);
+        varA += (ra[i] - mean) * (ra[i] - mean);
+        varB += (rb[i] - mean) * (rb[i] - mean);
+    }
+    return cov / std::sqrt(varA * varB);
+}
+
+int IntegratorStudyTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    int numScenarios = ToolArgInt(args, 1, 20);
+    int numDrones = std::clamp(ToolArgInt(args, 2, 100), 2, (int) GenerationSize);
+
+    TrainingSim training;
+    if (!training.LoadFromFile(fileName)) return 1;
+
+    // Drones spread over the whole population, elites and fresh children alike, as the selection sees them.
+    std::vector<const ControlNetwork*> nets;
+    for (int i = 0; i < numDrones; i++) nets.push_back(&training.Drones[(size_t) i * GenerationSize / numDrones].Brain);
+
+    auto scenarios = GenerateScenarios(numScenarios, IntegratorStudySeed);
+
+    // Mean penalty per drone and final states of every flight, drone-major.
+    struct StudyResult {
+        std::vector<FP> Penalties;
+        std::vector<DroneState> Finals;
+        std::vector<Vec2> Early;
+        long Evaluations = 0;
+        long Steps = 0;
+        double Seconds = 0.0;
+    };
+
+    auto run = [&] (const IntegratorSetup& setup) {
+        StudyResult result;
+        result.Penalties.resize(numDrones);
+        result.Finals.reserve(numDrones * numScenarios);
+        result.Early.resize(numDrones * numScenarios);
+
+        result.Seconds = MeasureSeconds([&] {
+            for (int d = 0; d < numDrones; d++) {
+                FP total = 0.0;
+                for (int s = 0; s < numScenarios; s++) {
+                    auto& scenario = scenarios[s];
+                    auto state = IntegratorFly(*nets[d], scenario, setup, result.Early[d * numScenarios + s], result.Evaluations, result.Steps);
+                    total += ScenarioPenalty(state, scenario.Target);
+                    result.Finals.push_back(state);
+                }
+                result.Penalties[d] = total / numScenarios;
+            }
+        });
+        return result;
+    };
+
+    std::cout << "Reference: RK4 with " << IntegratorReferenceSubsteps << " substeps per 60 Hz step, ";
+    std::cout << numDrones << " drones x " << numScenarios << " scenarios\n";
+
+    auto reference = run({Integrator::RK4, PhysicsSimDeltaT, 1, IntegratorReferenceSubsteps});
+    double flights = (double) numDrones * numScenarios;
+
+    std::cout << std::setw(22) << "integrator" << std::setw(8) << "dt" << std::setw(6) << "k";
+    std::cout << std::setw(12) << "evals/ep" << std::setw(12) << "steps/ep" << std::setw(12) << "us/ep";
+    std::cout << std::setw(14) << "1 s error" << std::setw(14) << "final error" << std::setw(14) << "penalty diff" << std::setw(12) << "rank corr" << "\n";
+
+    const IntegratorSetup timings[] = {
+        {Integrator::SemiImplicitEuler, PhysicsSimDeltaT, 1},
+        {Integrator::SemiImplicitEuler, PhysicsSimDeltaT * 2, 1},
+        {Integrator::SemiImplicitEuler, PhysicsSimDeltaT * 4, 1},
+        {Integrator::SemiImplicitEuler, PhysicsSimDeltaT, 2},
+        {Integrator::SemiImplicitEuler, PhysicsSimDeltaT, 4},
+    };
+
+    for (Integrator method : {Integrator::SemiImplicitEuler, Integrator::VelocityVerlet, Integrator::RK2, Integrator::RK4}) {
+        for (IntegratorSetup setup : timings) {
+            setup.Method = method;
+            auto result = run(setup);
+
+            // Position errors and relative penalty difference, averaged over the flights.
+            double earlyError = 0.0, finalError = 0.0;
+            for (size_t i = 0; i < result.Finals.size(); i++) {
+                earlyError += (result.Early[i] - reference.Early[i]).Mag() / flights;
+                finalError += (result.Finals[i].Position - reference.Finals[i].Position).Mag() / flights;
+            }
+
+            double penaltyDiff = 0.0;
+            for (int d = 0; d < numDrones; d++) {
+                penaltyDiff += std::abs(result.Penalties[d] - reference.Penalties[d]) / std::max(std::abs(reference.Penalties[d]), (FP) 1.0) / numDrones;
+            }
+
+            std::cout << std::fixed << std::setw(22) << IntegratorName(method);
+            std::cout << std::setw(8) << "1/" + std::to_string((int) std::round(1.0 / setup.DeltaT)) << std::setw(6) << setup.ControlInterval;
+            std::cout << std::setprecision(1) << std::setw(12) << result.Evaluations / flights << std::setw(12) << result.Steps / flights;
+            std::cout << std::setw(12) << result.Seconds * 1e6 / flights;
+            std::cout << std::scientific << std::setprecision(2) << std::setw(14) << earlyError << std::setw(14) << finalError << std::setw(14) << penaltyDiff;
+            std::cout << std::fixed << std::setprecision(4) << std::setw(12) << RankCorrelation(result.Penalties, reference.Penalties) << "\n";
+        }
+    }
+
+    std::cout << std::flush;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "NetworkJit.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+int JitTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    int numInputs = ToolArgInt(args, 1, 100000);
+
+    if (!NetworkJit::Supported()) {
+        std::cout << "JIT is not supported on this platform, EvaluateNetwork is always used." << std::endl;
+        return 0;
+    }
+
+    Drone drone;
+    if (!LoadCheckpointBest(fileName, drone)) {
+        std::cout << "Using a random network instead." << std::endl;
+    }
+
+    auto jit = NetworkJit::Compile(drone.Brain);
+    if (!jit) {
+        std::cerr << "Could not map executable memory." << std::endl;
+        return 1;
+    }
+
+    std::mt19937 gen {7};
+    std::normal_distribution<FP> dist {0.0, 3.0};
+
+    std::vector<std::array<FP, InputSize>> inputs(numInputs);
+    for (auto& input : inputs) {
+        for (auto& x : input) x = dist(gen);
+    }
+
+    // Training chooses between both paths by timing (`JitPolicy::Auto`), so reproducible runs need the exact same bits.
+    FP maxDiff = 0.0;
+    bool identical = true;
+    for (auto& input : inputs) {
+        auto expected = drone.Brain.EvaluateNetwork(input);
+        auto output = jit->EvaluateNetwork(input);
+        for (int i = 0; i < (int) OutputSize; i++) {
+            maxDiff = std::max(maxDiff, std::abs(expected[i] - output[i]) / (1.0 + std::abs(expected[i])));
+            identical = identical && std::bit_cast<uint64_t>(expected[i]) == std::bit_cast<uint64_t>(output[i]);
+        }
+    }
+
+    auto& model = NetworkJit::GetCostModel();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Generated code: " << jit->GetCodeSize() << " bytes\n";
+    std::cout << "Max relative difference vs EvaluateNetwork: " << std::scientific << maxDiff << std::fixed << "\n";
+    std::cout << "Bit-identical to EvaluateNetwork: " << (identical ? "yes" : "NO") << "\n\n";
+
+    std::cout << "Compile cost: " << model.CompileSeconds * 1e6 << " us per network\n";
+    std::cout << "EvaluateNetwork: " << model.InterpretedEvalSeconds * 1e9 << " ns per evaluation\n";
+    std::cout << "JIT: " << model.JitEvalSeconds * 1e9 << " ns per evaluation\n";
+    std::cout << "Break-even: " << model.BreakEvenEvaluations() << " evaluations\n\n";
+
+    FP evalsPerDrone = SimulationsPerDrone * (0.7652 * TrainingMaxCoords / PhysicsSimTargetDroneSpeed + 1.5) / PhysicsSimDeltaT;
+    std::cout << "A training evaluation is about " << evalsPerDrone << " network evaluations per drone, ";
+    std::cout << (model.PaysOff(evalsPerDrone) ? "JIT pays off" : "JIT does not pay off") << " with TrainingJitPolicy::Auto." << std::endl;
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "Kernels.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Row-by-row layer as `EvaluateNetwork` used to compute it, as the baseline for speed and for the exact results.
+static void NaiveLayer(const FP* w, const FP* b, int rows, int cols, const FP* x, FP* y) {
+    for (int i = 0; i < rows; i++) {
+        FP sum = 0;
+        for (int j = 0; j < cols; j++) {
+            sum += x[j] * w[i * cols + j] + b[i];
+        }
+        y[i] = LeakyReLUActivation::Apply(sum);
+    }
+}
+
+// Single core double precision peak, from independent FMA chains on native vectors.
+static double MeasurePeakFlops() {
+    constexpr int chains = 12;
+    constexpr long iterations = 20'000'000;
+
+    FPVec acc[chains];
+    for (int c = 0; c < chains; c++) acc[c] = SimdBroadcast(1.0 + c * 1e-3);
+
+    FPVec a = SimdBroadcast(0.999999);
+    FPVec b = SimdBroadcast(1e-7);
+
+    double seconds = MeasureSeconds([&] {
+        for (long i = 0; i < iterations; i++) {
+            for (int c = 0; c < chains; c++) acc[c] = acc[c] * a + b;
+            asm volatile("" : "+x"(a));
+        }
+    });
+
+    FP sink = 0.0;
+    for (int c = 0; c < chains; c++) sink += SimdSum(acc[c]);
+    if (sink == 0.123) std::cout << sink;
+
+    return 2.0 * SimdWidth * chains * iterations / seconds;
+}
+
+int KernelBenchTool(ToolArgs args) {
+    int maxHidden = ToolArgInt(args, 0, 512);
+    int batch = ToolArgInt(args, 1, SimulationsPerDrone);
+
+    double peak = MeasurePeakFlops();
+    std::cout << "Vector width: " << SimdWidth << " x " << sizeof(FP) * 8 << " bit\n";
+    std::cout << "Measured single core peak: " << std::fixed << std::setprecision(2) << peak / 1e9 << " GFLOP/s\n\n";
+    std::cout << "Network " << InputSize << "-h-h-" << OutputSize << ", single thread, GEMM batch " << batch << "\n\n";
+
+    std::cout << std::setw(8) << "hidden" << std::setw(14) << "naive GF/s" << std::setw(14) << "GEMV GF/s" << std::setw(14) << "GEMM GF/s" << std::setw(12) << "% peak" << std::setw(10) << "exact" << "\n";
+
+    std::mt19937 gen {3};
+    bool allExact = true;
+    std::normal_distribution<FP> dist {0.0, 0.3};
+
+    for (int hidden = 8; hidden <= maxHidden; hidden *= 2) {
+        int in = InputSize, out = OutputSize;
+
+        auto random = [&] (size_t n) {
+            std::vector<FP, SimdAllocator<FP>> v(n);
+            for (auto& x : v) x = dist(gen);
+            return v;
+        };
+
+        auto w1 = random(hidden * in), w2 = random(hidden * hidden), w3 = random(out * hidden);
+        auto b1 = random(hidden), b2 = random(hidden), b3 = random(out);
+        auto x = random(batch * in);
+
+        std::vector<FP, SimdAllocator<FP>> h1(batch * hidden), h2(batch * hidden), y(batch * out);
+
+        // Packed once, like the panels a network keeps next to its genome.
+        auto p1 = PackedMatrix::FromDense({w1.data(), (size_t) hidden, (size_t) in}, b1.data());
+        auto p2 = PackedMatrix::FromDense({w2.data(), (size_t) hidden, (size_t) hidden}, b2.data());
+        auto p3 = PackedMatrix::FromDense({w3.data(), (size_t) out, (size_t) hidden}, b3.data());
+
+        double flopsPerEval = 2.0 * (in * hidden + hidden * hidden + hidden * out);
+        long evals = std::max(2000L, (long) (4e8 / flopsPerEval));
+        long gemmCalls = std::max(1L, evals / batch);
+
+        double naiveSeconds = MeasureSeconds([&] {
+            for (long n = 0; n < evals; n++) {
+                NaiveLayer(w1.data(), b1.data(), hidden, in, x.data() + (n % batch) * in, h1.data());
+                NaiveLayer(w2.data(), b2.data(), hidden, hidden, h1.data(), h2.data());
+                NaiveLayer(w3.data(), b3.data(), out, hidden, h2.data(), y.data());
+            }
+        });
+
+        double gemvSeconds = MeasureSeconds([&] {
+            for (long n = 0; n < evals; n++) {
+                DenseLayer<LeakyReLUActivation>(p1, x.data() + (n % batch) * in, in, h1.data(), hidden, 1);
+                DenseLayer<LeakyReLUActivation>(p2, h1.data(), hidden, h2.data(), hidden, 1);
+                DenseLayer<LeakyReLUActivation>(p3, h2.data(), hidden, y.data(), out, 1);
+            }
+        });
+
+        double gemmSeconds = MeasureSeconds([&] {
+            for (long n = 0; n < gemmCalls; n++) {
+                DenseLayer<LeakyReLUActivation>(p1, x.data(), in, h1.data(), hidden, batch);
+                DenseLayer<LeakyReLUActivation>(p2, h1.data(), hidden, h2.data(), hidden, batch);
+                DenseLayer<LeakyReLUActivation>(p3, h2.data(), hidden, y.data(), out, batch);
+            }
+        });
+
+        // Every sample of the GEMM batch, and each one evaluated alone, must give the bits of the row-by-row loop.
+        bool exact = true;
+        std::vector<FP> n1(hidden), n2(hidden), ny(out), gy(out);
+        for (int n = 0; n < batch; n++) {
+            NaiveLayer(w1.data(), b1.data(), hidden, in, x.data() + n * in, n1.data());
+            NaiveLayer(w2.data(), b2.data(), hidden, hidden, n1.data(), n2.data());
+            NaiveLayer(w3.data(), b3.data(), out, hidden, n2.data(), ny.data());
+            exact = exact && std::equal(ny.begin(), ny.end(), y.begin() + n * out);
+
+            DenseLayer<LeakyReLUActivation>(p1, x.data() + n * in, in, n1.data(), hidden, 1);
+            DenseLayer<LeakyReLUActivation>(p2, n1.data(), hidden, n2.data(), hidden, 1);
+            DenseLayer<LeakyReLUActivation>(p3, n2.data(), hidden, gy.data(), out, 1);
+            exact = exact && gy == ny;
+        }
+
+        double naiveFlops = flopsPerEval * evals / naiveSeconds;
+        double gemvFlops = flopsPerEval * evals / gemvSeconds;
+        double gemmFlops = flopsPerEval * gemmCalls * batch / gemmSeconds;
+
+        std::cout << std::setw(8) << hidden;
+        std::cout << std::setw(14) << naiveFlops / 1e9 << std::setw(14) << gemvFlops / 1e9 << std::setw(14) << gemmFlops / 1e9;
+        std::cout << std::setw(11) << 100.0 * std::max(gemvFlops, gemmFlops) / peak << "%" << std::setw(10) << (exact ? "yes" : "NO") << "\n";
+        allExact = allExact && exact;
+    }
+
+    std::cout << std::flush;
+    return allExact ? 0 : 1;
+}
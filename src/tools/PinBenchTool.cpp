@@ -0,0 +1,82 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "TrainingSim.hpp"
+
+#include <ThreadPool.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Worker CPUs and their nodes, like "0/n0 1/n0", or "unpinned".
+static std::string PinBenchWorkers(const ll::ThreadPool& pool) {
+    std::stringstream workers;
+    for (int w = 0; w < (int) pool.GetThreadCount(); w++) {
+        if (pool.GetWorkerCpu(w) < 0) return "unpinned";
+        workers << (w > 0 ? " " : "") << pool.GetWorkerCpu(w) << "/n" << pool.GetWorkerNode(w);
+    }
+    return workers.str();
+}
+
+int PinBenchTool(ToolArgs args) {
+    int generations = std::max(1, ToolArgInt(args, 0, 5));
+    const char* cpuList = ToolArg(args, 1, nullptr);
+
+    const ll::CpuTopology& topology = ll::CpuTopology::Get();
+    std::cout << topology.Cpus.size() << " CPUs on " << topology.NumNodes << " NUMA nodes, " << SimulationThreads << " training threads\n";
+    std::cout << "Each placement builds a population from seed " << TrainingSeed << " and trains " << generations << " generations\n\n";
+
+    std::vector<std::pair<std::string, ll::Placement>> placements = {
+        {"unpinned", {ll::PinPolicy::None}},
+        {"compact", {ll::PinPolicy::Compact}},
+        {"scatter", {ll::PinPolicy::Scatter}},
+    };
+    if (cpuList) placements.push_back({"list", {ll::PinPolicy::List, ll::ParseCpuList(cpuList)}});
+
+    ll::ThreadPool& pool = TrainingSim::GetPool();
+
+    // The JIT cost model and the allocator warm up here, not in the first timed placement.
+    TrainingSim(TrainingSeed).TrainGeneration();
+
+    std::cout << std::setw(10) << "placement" << std::setw(12) << "init ms" << std::setw(14) << "generations/s" << std::setw(10) << "speedup" << std::setw(20) << "population hash" << "   workers (cpu/node)\n";
+
+    double unpinned = 0.0;
+    std::optional<uint64_t> reference;
+    bool sameResults = true;
+
+    for (auto& [name, placement] : placements) {
+        try {
+            pool.SetPlacement(placement);
+        }
+        catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        std::optional<TrainingSim> training;
+        double initSeconds = MeasureSeconds([&] { training.emplace(TrainingSeed); });
+        double seconds = MeasureSeconds([&] {
+            for (int g = 0; g < generations; g++) training->TrainGeneration();
+        });
+
+        double rate = generations / seconds;
+        if (placement.Policy == ll::PinPolicy::None) unpinned = rate;
+
+        uint64_t hash = PopulationHash(*training);
+        if (!reference) reference = hash;
+        sameResults = sameResults && hash == *reference;
+
+        std::cout << std::setw(10) << name << std::fixed << std::setprecision(2) << std::setw(12) << initSeconds * 1e3 << std::setw(14) << rate;
+        std::cout << std::setw(9) << rate / unpinned << "x" << std::hex << std::setw(20) << hash << std::dec << "   " << PinBenchWorkers(pool) << "\n";
+    }
+
+    pool.SetPlacement({});
+
+    std::cout << "\nSame population with every placement: " << (sameResults ? "yes" : "NO") << std::endl;
+    return sameResults ? 0 : 1;
+}
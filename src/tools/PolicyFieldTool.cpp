@@ -0,0 +1,76 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "PolicyField.hpp"
+
+#include <ThreadPool.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Parses "name" or "name:min:max" for each comma-separated axis.
+static bool ParsePolicyAxes(std::string_view spec, int steps, std::vector<PolicyAxisRange>& axes) {
+    while (!spec.empty()) {
+        auto comma = spec.find(',');
+        std::string item {spec.substr(0, comma)};
+        spec = comma == std::string_view::npos ? std::string_view {} : spec.substr(comma + 1);
+
+        auto colon = item.find(':');
+        auto axis = PolicyAxisFromName(std::string_view(item).substr(0, colon));
+        if (!axis) {
+            std::cerr << "Unknown axis '" << item.substr(0, colon) << "'." << std::endl;
+            return false;
+        }
+
+        auto range = DefaultPolicyAxisRange(*axis, steps);
+        if (colon != std::string::npos) {
+            char* end = nullptr;
+            range.Min = std::strtod(item.c_str() + colon + 1, &end);
+            if (*end != ':') {
+                std::cerr << "Expected 'name:min:max', got '" << item << "'." << std::endl;
+                return false;
+            }
+            range.Max = std::strtod(end + 1, nullptr);
+        }
+
+        axes.push_back(range);
+    }
+
+    return !axes.empty();
+}
+
+int PolicyFieldTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    std::string_view outName = ToolArg(args, 1, "policy_field.bin");
+    std::string_view axesSpec = ToolArg(args, 2, "offset-x,offset-y,angle");
+    int steps = ToolArgInt(args, 3, 128);
+
+    Drone drone;
+    if (!LoadCheckpointBest(fileName, drone)) return 1;
+
+    PolicyField field;
+    if (!ParsePolicyAxes(axesSpec, steps, field.Axes)) return 1;
+
+    ll::ThreadPool pool {std::max(1u, std::thread::hardware_concurrency())};
+
+    double seconds = MeasureSeconds([&] {
+        field.Evaluate(drone.Brain, pool);
+    });
+
+    size_t count = field.PointCount();
+    std::cout << "Evaluated " << count << " states on " << std::max(1u, std::thread::hardware_concurrency()) << " threads in " << seconds << " s ";
+    std::cout << "(" << count / seconds / 1e6 << " M evaluations/sec)" << std::endl;
+
+    bool csv = outName.ends_with(".csv");
+    std::string outPath {outName};
+
+    if (!(csv ? field.WriteCsv(outPath.c_str()) : field.WriteBinary(outPath.c_str()))) {
+        std::cerr << "Could not write '" << outPath << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << (csv ? "CSV" : "binary") << " thrust field to " << outPath << "." << std::endl;
+    return 0;
+}
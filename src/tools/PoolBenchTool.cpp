@@ -0,0 +1,269 @@
+#include "Tools.hpp"
+
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Heap allocations are counted while `PoolBenchCounting` is set, on every thread and from any source: the pool's block
+// caches and deques, tasks too large to store inline, and the per-call vectors of `For`, `TransformReduce` and the
+// scans. Replacing the global `operator new` affects all of scptools, where it costs one relaxed load per allocation.
+// The default `operator delete` frees with `std::free`.
+static std::atomic<bool> PoolBenchCounting = false;
+static std::atomic<long> PoolBenchAllocations = 0;
+
+void* operator new(size_t size) {
+    if (PoolBenchCounting.load(std::memory_order_relaxed)) PoolBenchAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    if (PoolBenchCounting.load(std::memory_order_relaxed)) PoolBenchAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = std::max(sizeof(void*), (size_t) align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw std::bad_alloc();
+}
+
+enum class PoolBenchPattern {
+    External,   // Every task submitted from the main thread.
+    Post,       // Same, without a future.
+    Batch,      // Same, counted by a `TaskBatch` and waited on through it.
+    Nested,     // One root task per thread, each submitting its share of the tasks from inside the pool.
+    For,        // `ThreadPool::For` over every task, waiting on the returned futures.
+    Static,     // `ThreadPool::ParallelFor` over every index, with each partition.
+    Guided,
+    Auto,
+    Reduce,     // `ThreadPool::TransformReduce` over every index, deterministic order.
+};
+
+// A few hundred nanoseconds of work, so the scheduler is most of the cost.
+static uint64_t PoolBenchWork(int i) {
+    uint64_t x = i + 1;
+    for (int k = 0; k < 64; k++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+// Runs `results.size()` tiny tasks on `pool` and returns the seconds taken.
+static double PoolBenchRun(ll::ThreadPool& pool, PoolBenchPattern pattern, std::vector<uint64_t>& results) {
+    int numTasks = results.size();
+    int threads = pool.GetThreadCount();
+    std::fill(results.begin(), results.end(), 0);
+
+    auto tiny = [&results] (int i) {
+        results[i] = PoolBenchWork(i);
+    };
+
+    return MeasureSeconds([&] {
+        switch (pattern) {
+            case PoolBenchPattern::External:
+                for (int i = 0; i < numTasks; i++) pool.Submit(tiny, i);
+                pool.WaitUntilEmpty();
+                break;
+
+            case PoolBenchPattern::Post:
+                for (int i = 0; i < numTasks; i++) pool.Post(tiny, i);
+                pool.WaitUntilEmpty();
+                break;
+
+            case PoolBenchPattern::Batch: {
+                ll::TaskBatch batch;
+                for (int i = 0; i < numTasks; i++) pool.Post(batch, tiny, i);
+                batch.Wait();
+                break;
+            }
+
+            case PoolBenchPattern::Nested:
+                for (int r = 0; r < threads; r++) {
+                    pool.Post([&pool, &tiny, first = r * numTasks / threads, last = (r + 1) * numTasks / threads] {
+                        for (int i = first; i < last; i++) pool.Submit(tiny, i);
+                    });
+                }
+                pool.WaitUntilEmpty();
+                break;
+
+            case PoolBenchPattern::For:
+                pool.For(0, numTasks, tiny).Wait();
+                break;
+
+            case PoolBenchPattern::Static:
+            case PoolBenchPattern::Guided:
+            case PoolBenchPattern::Auto: {
+                auto partition = pattern == PoolBenchPattern::Static ? ll::Partition::Static : pattern == PoolBenchPattern::Guided ? ll::Partition::Guided : ll::Partition::Auto;
+                pool.ParallelFor(0, numTasks, 1, [&] (ll::IndexRange range) {
+                    for (int i = range.Begin; i < range.End; i++) tiny(i);
+                }, partition);
+                break;
+            }
+
+            case PoolBenchPattern::Reduce:
+                pool.TransformReduce(0, numTasks, 1, uint64_t(0), std::bit_xor<uint64_t>(), [&results] (int i) {
+                    return results[i] = PoolBenchWork(i);
+                });
+                break;
+        }
+    });
+}
+
+int PoolBenchTool(ToolArgs args) {
+    int numTasks = ToolArgInt(args, 0, 200000);
+    int maxThreads = std::max(1, ToolArgInt(args, 1, std::thread::hardware_concurrency()));
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    const std::pair<const char*, ll::Scheduler> schedulers[] = {
+        {"shared queue", ll::Scheduler::SharedQueue},
+        {"work stealing", ll::Scheduler::WorkStealing},
+        {"lock-free queue", ll::Scheduler::LockFreeQueue},
+    };
+
+    const std::pair<const char*, PoolBenchPattern> patterns[] = {
+        {"external submit", PoolBenchPattern::External},
+        {"external post", PoolBenchPattern::Post},
+        {"batch post", PoolBenchPattern::Batch},
+        {"nested submit", PoolBenchPattern::Nested},
+        {"For", PoolBenchPattern::For},
+        {"ParallelFor static", PoolBenchPattern::Static},
+        {"ParallelFor guided", PoolBenchPattern::Guided},
+        {"ParallelFor auto", PoolBenchPattern::Auto},
+        {"TransformReduce", PoolBenchPattern::Reduce},
+    };
+
+    std::cout << numTasks << " tiny tasks per run, " << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << "Millions of tasks per second (speedup over 1 thread)\n\n";
+    std::cout << std::setw(20) << "pattern" << std::setw(9) << "threads";
+    for (auto& [name, scheduler] : schedulers) std::cout << std::setw(24) << name;
+    std::cout << "\n";
+
+    std::vector<uint64_t> results(numTasks);
+    bool allRan = true;
+
+    for (auto& [patternName, pattern] : patterns) {
+        std::vector<double> single(std::size(schedulers));
+
+        for (int threads : threadCounts) {
+            std::cout << std::setw(20) << patternName << std::setw(9) << threads;
+
+            for (size_t s = 0; s < std::size(schedulers); s++) {
+                // The pool is built and torn down outside the timing.
+                ll::ThreadPool pool(threads, schedulers[s].second);
+                double seconds = PoolBenchRun(pool, pattern, results);
+                if (threads == 1) single[s] = seconds;
+
+                for (int i = 0; i < numTasks; i++) allRan = allRan && results[i] == PoolBenchWork(i);
+
+                std::cout << std::fixed << std::setprecision(2) << std::setw(16) << numTasks / seconds * 1e-6;
+                std::cout << " (" << std::setw(5) << single[s] / seconds << "x)";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "\nEvery task ran exactly once: " << (allRan ? "yes" : "NO") << "\n";
+
+    // Once queues and block pools have grown in a first run, a second run should not touch the heap, except for a few
+    // blocks refilling the cache of a thread whose blocks were freed elsewhere.
+    std::cout << "\nHeap allocations per task after a warm-up run, " << maxThreads << " threads\n\n";
+    std::cout << std::setw(20) << "pattern";
+    for (auto& [name, scheduler] : schedulers) std::cout << std::setw(24) << name;
+    std::cout << "\n";
+
+    bool allocationFree = true;
+    for (auto& [patternName, pattern] : patterns) {
+        std::cout << std::setw(20) << patternName;
+
+        for (auto& [name, scheduler] : schedulers) {
+            ll::ThreadPool pool(maxThreads, scheduler);
+            PoolBenchRun(pool, pattern, results);
+
+            PoolBenchAllocations = 0;
+            PoolBenchCounting = true;
+            PoolBenchRun(pool, pattern, results);
+            PoolBenchCounting = false;
+
+            double perTask = (double) PoolBenchAllocations / numTasks;
+            allocationFree = allocationFree && perTask < 1e-3;
+
+            std::cout << std::setprecision(5) << std::setw(24) << perTask;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "\nUnder one heap allocation per thousand tasks: " << (allocationFree ? "yes" : "NO") << std::endl;
+
+    // A batch must finish while an unrelated task still holds a worker, which `WaitUntilEmpty` would wait for.
+    bool independent = true;
+    int batchTasks = std::min(numTasks, 1000);
+    for (auto& [name, scheduler] : schedulers) {
+        ll::ThreadPool pool(std::max(maxThreads, 2), scheduler);
+        std::atomic<bool> release = false;
+        pool.Post([&release] {
+            while (!release) release.wait(false);
+        });
+
+        ll::TaskBatch batch;
+        std::fill(results.begin(), results.end(), 0);
+        for (int i = 0; i < batchTasks; i++) pool.Post(batch, [&results, i] { results[i] = PoolBenchWork(i); });
+        batch.Wait();
+
+        for (int i = 0; i < batchTasks; i++) independent = independent && results[i] == PoolBenchWork(i);
+        independent = independent && pool.GetRemainingTasks() == 0;
+
+        release = true;
+        release.notify_all();
+    }
+
+    std::cout << "Batches finish while other tasks are running: " << (independent ? "yes" : "NO") << std::endl;
+
+    // A deterministic floating-point sum must not change with the threads or the scheduler; scans must match <numeric>.
+    std::vector<double> terms(numTasks);
+    for (int i = 0; i < numTasks; i++) terms[i] = (i % 2 ? -1.0 : 1.0) / (i + 1) * (double) (PoolBenchWork(i) % 1000);
+
+    std::vector<long> flags(numTasks), inclusive(numTasks), exclusive(numTasks);
+    for (int i = 0; i < numTasks; i++) flags[i] = PoolBenchWork(i) % 3 == 0;
+    std::inclusive_scan(flags.begin(), flags.end(), inclusive.begin());
+    std::exclusive_scan(flags.begin(), flags.end(), exclusive.begin(), 0L);
+
+    std::optional<double> reference;
+    bool reduceRepeats = true;
+    bool scansMatch = true;
+    for (int threads : threadCounts) {
+        for (auto& [name, scheduler] : schedulers) {
+            ll::ThreadPool pool(threads, scheduler);
+            double sum = pool.Reduce(terms, 256, 0.0, std::plus<>());
+            if (!reference) reference = sum;
+            reduceRepeats = reduceRepeats && sum == *reference;
+
+            long count = pool.Reduce(flags, 256, 0L, std::plus<>(), ll::ReduceOrder::Unordered);
+            scansMatch = scansMatch && count == inclusive.back();
+
+            std::vector<long> scanned(numTasks);
+            pool.InclusiveScan(flags, scanned, 256, std::plus<>());
+            scansMatch = scansMatch && scanned == inclusive;
+
+            scanned = flags;
+            pool.ExclusiveScan(scanned, scanned, 256, 0L, std::plus<>());
+            scansMatch = scansMatch && scanned == exclusive;
+        }
+    }
+
+    std::cout << "Deterministic sums identical on every thread count and scheduler: " << (reduceRepeats ? "yes" : "NO") << "\n";
+    std::cout << "Scans and unordered integer reductions match the serial ones: " << (scansMatch ? "yes" : "NO") << std::endl;
+    return allRan && allocationFree && independent && reduceRepeats && scansMatch ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "Scenario.hpp"
+#include "TrainingSim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+static constexpr uint32_t PruneEvaluationSeed = 3;
+
+int PruneTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    const char* outName = ToolArg(args, 1, "pruned.gen");
+    FP tolerance = ToolArgInt(args, 2, 1) / 100.0;
+    int numScenarios = ToolArgInt(args, 3, 200);
+
+    TrainingSim training;
+    if (!training.LoadFromFile(fileName)) return 1;
+
+    const ControlNetwork& original = training.Drones[0].Brain;
+    auto scenarios = GenerateScenarios(numScenarios, PruneEvaluationSeed);
+
+    std::vector<std::array<FP, InputSize>> inputs;
+    FP basePenalty = MeanScenarioPenalty(original, scenarios, &inputs);
+
+    auto weights = original.GetGenome().first<ControlNetwork::WeightCount>();
+    std::vector<FP> magnitudes(weights.size());
+    std::transform(weights.begin(), weights.end(), magnitudes.begin(), [] (FP w) { return std::abs(w); });
+    std::sort(magnitudes.begin(), magnitudes.end());
+
+    FP checksum = 0.0;
+    ControlNetwork dense = original;
+    dense.UpdateLayout();
+    double denseNanos = NanosPerEvaluation(dense, inputs, checksum);
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Closed-loop penalty over " << numScenarios << " scenarios: " << basePenalty << ", accepting up to +" << tolerance * 100 << "%\n";
+    std::cout << "Dense evaluation: " << std::setprecision(2) << denseNanos << " ns\n\n";
+
+    std::cout << std::setw(10) << "sparsity" << std::setw(14) << "threshold" << std::setw(14) << "penalty" << std::setw(14) << "sparse ns" << std::setw(10) << "speedup" << "\n";
+
+    ControlNetwork best = original;
+    FP bestSparsity = original.GetSparsity();
+
+    for (int percent = 5; percent < 100; percent += 5) {
+        size_t index = magnitudes.size() * percent / 100;
+        FP threshold = magnitudes[index];
+
+        ControlNetwork pruned = original;
+        pruned.Prune(threshold);
+
+        FP penalty = MeanScenarioPenalty(pruned, scenarios);
+
+        pruned.UpdateLayout(true);
+        double sparseNanos = NanosPerEvaluation(pruned, inputs, checksum);
+
+        bool accepted = penalty <= basePenalty * (1.0 + tolerance);
+
+        std::cout << std::setprecision(4);
+        std::cout << std::setw(9) << pruned.GetSparsity() * 100 << "%" << std::setw(14) << threshold << std::setw(14) << penalty;
+        std::cout << std::setprecision(2) << std::setw(14) << sparseNanos << std::setw(9) << denseNanos / sparseNanos << "x";
+        std::cout << (accepted ? "" : "    rejected") << "\n";
+
+        // Every level is checked closed-loop on its own, so a later level can still be accepted after a rejected one.
+        if (!accepted) continue;
+
+        pruned.UpdateLayout();
+        best = pruned;
+        bestSparsity = pruned.GetSparsity();
+    }
+
+    training.Drones[0].Brain = best;
+    training.Drones[0].CompiledBrain.reset();
+    training.SaveToFile(outName);
+
+    std::cout << "\nKept " << std::setprecision(1) << bestSparsity * 100 << "% sparsity, ";
+    std::cout << "evaluated with the dense kernels" << ". Wrote " << outName << ".\n";
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
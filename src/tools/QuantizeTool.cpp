@@ -0,0 +1,85 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "QuantizedNetwork.hpp"
+#include "Scenario.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+static constexpr uint32_t CalibrationSeed = 1;
+static constexpr uint32_t EvaluationSeed = 2;
+static constexpr int CalibrationScenarios = 200;
+
+int QuantizeTool(ToolArgs args) {
+    const char* fileName = ToolArg(args, 0, CheckpointFileName);
+    int numScenarios = ToolArgInt(args, 1, 100);
+
+    if (!QuantizedNetwork::Supported()) {
+        std::cerr << "Quantization only supports the leaky ReLU activation, this build uses " << ControlNetwork::ActivationType::Name << "." << std::endl;
+        return 1;
+    }
+
+    Drone drone;
+    if (!LoadCheckpointBest(fileName, drone)) return 1;
+
+    std::vector<std::array<FP, InputSize>> recorded;
+    for (auto& scenario : GenerateScenarios(CalibrationScenarios, CalibrationSeed)) {
+        FlyScenario(drone, scenario, false, &recorded);
+    }
+
+    auto calibration = QuantizedNetwork::Calibrate(drone.Brain, recorded);
+    QuantizedNetwork quantized(drone.Brain, calibration);
+
+    std::cout << "Calibrated on " << recorded.size() << " recorded states from " << CalibrationScenarios << " scenarios.\n";
+    std::cout << "Hidden ranges: " << calibration.Hidden1Range << ", " << calibration.Hidden2Range << "\n\n";
+
+    auto quantController = [&quantized] (const std::array<FP, InputSize>& input) {
+        return quantized.EvaluateNetwork(input);
+    };
+
+    FP floatPenalty = 0.0;
+    FP quantPenalty = 0.0;
+    FP meanDeviation = 0.0;
+    FP maxDeviation = 0.0;
+    FP meanFinalDeviation = 0.0;
+    int deviationSamples = 0;
+
+    std::vector<std::array<FP, InputSize>> evalInputs;
+    auto scenarios = GenerateScenarios(numScenarios, EvaluationSeed);
+
+    for (auto& scenario : scenarios) {
+        auto floatFlight = FlyScenario(drone, scenario, true, &evalInputs);
+        auto quantFlight = FlyScenario(drone, scenario, quantController, true);
+
+        floatPenalty += floatFlight.Penalty / numScenarios;
+        quantPenalty += quantFlight.Penalty / numScenarios;
+
+        for (int i = 0; i < floatFlight.Steps; i++) {
+            FP deviation = (floatFlight.Trajectory[i] - quantFlight.Trajectory[i]).Mag();
+            meanDeviation += deviation;
+            maxDeviation = std::max(maxDeviation, deviation);
+            deviationSamples++;
+        }
+        meanFinalDeviation += (floatFlight.Trajectory.back() - quantFlight.Trajectory.back()).Mag() / numScenarios;
+    }
+    meanDeviation /= deviationSamples;
+
+    FP checksum = 0.0;
+    double floatRate = 1e9 / NanosPerEvaluation(drone.Brain, evalInputs, checksum);
+    double quantRate = 1e9 / NanosPerEvaluation(quantized, evalInputs, checksum);
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Closed loop over " << numScenarios << " scenarios:\n";
+    std::cout << std::setw(28) << "" << std::setw(16) << "float" << std::setw(16) << "int8" << "\n";
+    std::cout << std::setw(28) << "Mean penalty" << std::setw(16) << floatPenalty << std::setw(16) << quantPenalty << "\n";
+    std::cout << std::setw(28) << "Evaluations/sec (M)" << std::setw(16) << floatRate / 1e6 << std::setw(16) << quantRate / 1e6 << "\n\n";
+
+    std::cout << "Trajectory deviation (int8 vs float):\n";
+    std::cout << "    mean: " << meanDeviation << "\n";
+    std::cout << "    max: " << maxDeviation << "\n";
+    std::cout << "    mean at end of flight: " << meanFinalDeviation << "\n";
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "ControlNetwork.hpp"
+#include "Reproduction.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static constexpr FP ReproduceBenchRate = 0.5;
+
+// Child as `GenerateChild` used to build it: zeroed genome, fresh distribution, scalar averaging, one mutated gene.
+static std::vector<FP> LegacyChild(const std::vector<FP>& a, const std::vector<FP>& b, std::mt19937& gen) {
+    std::normal_distribution<FP> dist {0.0, ReproduceBenchRate};
+    std::vector<FP> out(a.size());
+
+    for (size_t i = 0; i < a.size(); i++) out[i] = (a[i] + b[i]) / 2;
+    out[rand() % out.size()] += dist(gen);
+    return out;
+}
+
+int ReproduceBenchTool(ToolArgs args) {
+    int children = ToolArgInt(args, 0, GenerationSize - SelectNBest);
+    int repeats = ToolArgInt(args, 1, 200);
+
+    std::mt19937 legacyGen {5};
+    std::mt19937_64 gen {5};
+    std::normal_distribution<FP> dist {0.0, 1.0};
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Reproducing " << children << " children from " << SelectNBest << " parents, single thread\n\n";
+    std::cout << std::setw(10) << "genome" << std::setw(26) << "variant" << std::setw(14) << "ns/child" << std::setw(12) << "GB/s" << std::setw(10) << "speedup" << "\n";
+
+    // The network's own genome, then wide ones where the population no longer fits in cache.
+    for (size_t size : {ControlNetwork::GenomeSize, (size_t) 1024, (size_t) 16384}) {
+        // Fewer repeats for the wide genomes, so every row takes a similar time.
+        int sizeRepeats = std::max<int>(1, repeats * ControlNetwork::GenomeSize / size);
+
+        std::vector<std::vector<FP>> legacyParents(SelectNBest, std::vector<FP>(size));
+        for (auto& p : legacyParents) for (auto& x : p) x = dist(gen);
+
+        std::vector<FP, SimdAllocator<FP>> parents(SelectNBest * size), population(children * size);
+        for (int p = 0; p < (int) SelectNBest; p++) std::copy(legacyParents[p].begin(), legacyParents[p].end(), parents.begin() + p * size);
+
+        // Touch the population once, so the first variant does not pay for the page faults.
+        std::fill(population.begin(), population.end(), 0.0);
+
+        auto parent = [&] (uint64_t r) {
+            return std::span<const FP>(parents).subspan((r % SelectNBest) * size, size);
+        };
+
+        // The legacy path appends to a population, as `TrainGeneration` did.
+        std::vector<std::vector<FP>> legacyPopulation;
+        double legacySeconds = MeasureSeconds([&] {
+            for (int r = 0; r < sizeRepeats; r++) {
+                legacyPopulation.clear();
+                for (int c = 0; c < children; c++) {
+                    legacyPopulation.push_back(LegacyChild(legacyParents[legacyGen() % SelectNBest], legacyParents[legacyGen() % SelectNBest], legacyGen));
+                }
+            }
+        });
+
+        double bytesPerChild = 3.0 * size * sizeof(FP);
+        double legacyNanos = legacySeconds * 1e9 / ((double) children * sizeRepeats);
+
+        std::cout << std::setw(10) << size << std::setw(26) << "legacy average, 1 gene" << std::setw(14) << legacyNanos;
+        std::cout << std::setw(12) << bytesPerChild / legacyNanos << std::setw(10) << "" << "\n";
+
+        struct Variant {
+            const char* Name;
+            ReproductionParams Params;
+        };
+
+        Variant variants[] = {
+            {"average, 1 gene", {CrossoverKind::Average, ReproduceBenchRate, 1}},
+            {"average, 8 genes", {CrossoverKind::Average, ReproduceBenchRate, 8}},
+            {"average, all genes", {CrossoverKind::Average, ReproduceBenchRate, size}},
+            {"uniform, 1 gene", {CrossoverKind::Uniform, ReproduceBenchRate, 1}},
+            {"uniform, all genes", {CrossoverKind::Uniform, ReproduceBenchRate, size}},
+        };
+
+        for (auto& variant : variants) {
+            double seconds = MeasureSeconds([&] {
+                for (int r = 0; r < sizeRepeats; r++) {
+                    for (int c = 0; c < children; c++) {
+                        std::span<FP> child(population.data() + c * size, size);
+                        Reproduce(child, parent(gen()), parent(gen()), variant.Params, gen);
+                    }
+                }
+            });
+
+            double nanos = seconds * 1e9 / ((double) children * sizeRepeats);
+            std::cout << std::setw(10) << "" << std::setw(26) << variant.Name << std::setw(14) << nanos;
+            std::cout << std::setw(12) << bytesPerChild / nanos << std::setw(9) << legacyNanos / nanos << "x\n";
+        }
+
+        FP checksum = 0.0;
+        for (size_t i = 0; i < population.size(); i += size) checksum += population[i];
+        for (auto& child : legacyPopulation) checksum += child[0];
+        std::cout << std::setw(10) << "" << "(checksum " << checksum << ")\n\n";
+    }
+
+    std::cout << std::flush;
+    return 0;
+}
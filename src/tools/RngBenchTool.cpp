@@ -0,0 +1,173 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "CounterRng.hpp"
+#include "RandomBatch.hpp"
+#include "Reproduction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static constexpr int RngBenchRepeats = 20;
+static constexpr int RngUniformBins = 1024;
+
+static void RngRow(const char* name, double nanos, double baseline) {
+    std::cout << std::setw(34) << name << std::setw(12) << nanos << std::setw(10) << baseline / nanos << "x\n";
+}
+
+// Sample moments: mean, variance, skewness and excess kurtosis.
+static std::array<double, 4> RngMoments(const std::vector<FP>& values) {
+    double mean = 0.0;
+    for (FP v : values) mean += v;
+    mean /= values.size();
+
+    double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    for (FP v : values) {
+        double d = v - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    m2 /= values.size();
+    m3 /= values.size();
+    m4 /= values.size();
+
+    return {mean, m2, m3 / std::pow(m2, 1.5), m4 / (m2 * m2) - 3.0};
+}
+
+static void RngCheckRow(const char* name, double value, double expected, double tolerance, bool& passed) {
+    bool ok = std::abs(value - expected) <= tolerance;
+    passed = passed && ok;
+
+    std::cout << std::setw(34) << name << std::setw(14) << value << std::setw(14) << expected;
+    std::cout << std::setw(14) << tolerance << (ok ? "      ok" : "      FAIL") << "\n";
+}
+
+int RngBenchTool(ToolArgs args) {
+    int count = ToolArgInt(args, 0, 1 << 20);
+
+    std::vector<uint64_t> bits(count);
+    std::vector<FP> values(count);
+    uint64_t checksum = 0;
+
+    // Same stream drawn one at a time and in bulk: the batch path must not change a single bit.
+    RngKey key {TrainingSeed, 3, 7};
+    {
+        CounterRng scalar(key, RngStream::Reproduction), batch(key, RngStream::Reproduction);
+        std::vector<uint64_t> expected(count);
+        for (auto& w : expected) w = scalar();
+
+        // An odd first draw leaves half a block behind, so `Fill` also has to pick up from the middle of one.
+        bits[0] = batch();
+        batch.Fill(std::span(bits).subspan(1));
+
+        bool same = bits == expected;
+        std::cout << "CounterRng::Fill against one draw at a time: " << (same ? "identical" : "DIFFERENT") << "\n\n";
+        if (!same) return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Throughput over " << count << " values, single thread\n\n";
+    std::cout << std::setw(34) << "generator" << std::setw(12) << "ns/value" << std::setw(11) << "speedup" << "\n";
+
+    std::mt19937_64 mt {TrainingSeed};
+
+    double mtBits = NanosPerItem(count, RngBenchRepeats, [&] { for (auto& w : bits) w = mt(); });
+    RngRow("mt19937_64 bits", mtBits, mtBits);
+    RngRow("CounterRng bits, one at a time", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Reproduction);
+        for (auto& w : bits) w = rng();
+    }), mtBits);
+    RngRow("CounterRng::Fill bits", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Reproduction);
+        FillRandomBits(rng, std::span(bits));
+    }), mtBits);
+    checksum += bits[count / 2];
+
+    std::uniform_real_distribution<FP> uniform {0.0, 1.0};
+    double mtUniform = NanosPerItem(count, RngBenchRepeats, [&] { for (auto& v : values) v = uniform(mt); });
+    RngRow("mt19937_64 uniform_real", mtUniform, mtUniform);
+    RngRow("CounterRng::UniformFP", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Scenarios);
+        for (auto& v : values) v = rng.UniformFP(0.0, 1.0);
+    }), mtUniform);
+    RngRow("FillUniform", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Scenarios);
+        FillUniform(rng, std::span(values), 0.0, 1.0);
+    }), mtUniform);
+    checksum += std::bit_cast<uint64_t>(values[count / 3]);
+
+    std::normal_distribution<FP> normal {0.0, 1.0};
+    double mtNormal = NanosPerItem(count, RngBenchRepeats, [&] { for (auto& v : values) v = normal(mt); });
+    RngRow("mt19937_64 normal_distribution", mtNormal, mtNormal);
+    RngRow("CounterRng GaussianPair", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Initialization);
+        for (size_t i = 0; i + 1 < values.size(); i += 2) std::tie(values[i], values[i + 1]) = GaussianPair(1.0, rng);
+    }), mtNormal);
+    RngRow("FillNormal", NanosPerItem(count, RngBenchRepeats, [&] {
+        CounterRng rng(key, RngStream::Initialization);
+        FillNormal(rng, std::span(values), 1.0);
+    }), mtNormal);
+    checksum += std::bit_cast<uint64_t>(values[count / 4]);
+
+    // Statistical checks on the batch outputs, with tolerances of about five standard errors.
+    bool passed = true;
+    double n = count;
+
+    std::cout << "\nQuality\n\n" << std::setprecision(5);
+    std::cout << std::setw(34) << "statistic" << std::setw(14) << "value" << std::setw(14) << "expected" << std::setw(14) << "tolerance" << "\n";
+
+    CounterRng uniformRng(key, RngStream::Scenarios);
+    FillUniform(uniformRng, std::span(values), 0.0, 1.0);
+
+    auto uniformMoments = RngMoments(values);
+    RngCheckRow("uniform mean", uniformMoments[0], 0.5, 5 * std::sqrt(1.0 / 12 / n), passed);
+    RngCheckRow("uniform variance", uniformMoments[1], 1.0 / 12, 5 * std::sqrt(1.0 / 180 / n), passed);
+
+    std::vector<double> bins(RngUniformBins);
+    for (FP v : values) bins[std::min<int>(v * RngUniformBins, RngUniformBins - 1)]++;
+    double chiSquare = 0.0;
+    for (double b : bins) chiSquare += (b - n / RngUniformBins) * (b - n / RngUniformBins) / (n / RngUniformBins);
+    RngCheckRow("uniform chi-square, 1024 bins", chiSquare, RngUniformBins - 1, 5 * std::sqrt(2.0 * (RngUniformBins - 1)), passed);
+
+    double serial = 0.0;
+    for (int i = 0; i + 1 < count; i++) serial += (values[i] - 0.5) * (values[i + 1] - 0.5);
+    RngCheckRow("uniform lag-1 correlation", serial / (n - 1) * 12, 0.0, 5 / std::sqrt(n), passed);
+
+    // Neighbouring streams (next drone) must be independent of each other.
+    CounterRng neighbourRng({key.Seed, key.Generation, key.Drone + 1}, RngStream::Scenarios);
+    std::vector<FP> neighbour(count);
+    FillUniform(neighbourRng, std::span(neighbour), 0.0, 1.0);
+    double cross = 0.0;
+    for (int i = 0; i < count; i++) cross += (values[i] - 0.5) * (neighbour[i] - 0.5);
+    RngCheckRow("correlation with next drone", cross / n * 12, 0.0, 5 / std::sqrt(n), passed);
+
+    CounterRng bitRng(key, RngStream::Reproduction);
+    FillRandomBits(bitRng, std::span(bits));
+    double worstBit = 0.5;
+    for (int b = 0; b < 64; b++) {
+        double ones = 0.0;
+        for (uint64_t w : bits) ones += (w >> b) & 1;
+        if (std::abs(ones / n - 0.5) > std::abs(worstBit - 0.5)) worstBit = ones / n;
+    }
+    RngCheckRow("worst bit frequency", worstBit, 0.5, 5 * 0.5 / std::sqrt(n), passed);
+
+    CounterRng normalRng(key, RngStream::Initialization);
+    FillNormal(normalRng, std::span(values), 1.0);
+
+    auto normalMoments = RngMoments(values);
+    RngCheckRow("normal mean", normalMoments[0], 0.0, 5 / std::sqrt(n), passed);
+    RngCheckRow("normal variance", normalMoments[1], 1.0, 5 * std::sqrt(2.0 / n), passed);
+    RngCheckRow("normal skewness", normalMoments[2], 0.0, 5 * std::sqrt(6.0 / n), passed);
+    RngCheckRow("normal excess kurtosis", normalMoments[3], 0.0, 5 * std::sqrt(24.0 / n), passed);
+
+    double tail = std::count_if(values.begin(), values.end(), [] (FP v) { return std::abs(v) > 3.0; }) / n;
+    double tailExpected = std::erfc(3.0 / std::numbers::sqrt2);
+    RngCheckRow("normal fraction beyond 3 sigma", tail, tailExpected, 5 * std::sqrt(tailExpected / n), passed);
+
+    std::cout << "\n(checksum " << checksum << ")" << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "TrainingSim.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <optional>
+
+int RunHashTool(ToolArgs args) {
+    int generations = ToolArgInt(args, 0, 5);
+    uint64_t seed = ToolArgInt(args, 1, TrainingSeed);
+
+    std::optional<TrainingSim> created;
+    double initSeconds = MeasureSeconds([&] { created.emplace(seed); });
+    TrainingSim& training = *created;
+
+    std::cout << "Training " << generations << " generations from seed " << seed << " on " << SimulationThreads << " threads\n";
+    std::cout << "Initial population of " << GenerationSize << " drones built in " << std::setprecision(3) << initSeconds * 1e3 << " ms\n\n";
+    std::cout << std::setw(6) << "gen" << std::setw(26) << "mean penalty" << std::setw(26) << "best penalty" << std::setw(20) << "population hash" << std::setw(10) << "s" << "\n";
+
+    double totalSeconds = 0.0;
+    for (int g = 0; g < generations; g++) {
+        FP meanPenalty = 0.0;
+        double seconds = MeasureSeconds([&] { meanPenalty = training.TrainGeneration(); });
+        totalSeconds += seconds;
+
+        std::cout << std::setw(6) << training.GenerationsDone << std::setprecision(17) << std::setw(26) << meanPenalty << std::setw(26) << training.Drones[0].TrainingScore;
+        std::cout << std::hex << std::setw(20) << PopulationHash(training) << std::dec << std::setprecision(3) << std::setw(10) << seconds << "\n";
+    }
+
+    std::cout << "\n" << std::setprecision(3) << generations / totalSeconds << " generations/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "Tools.hpp"
+#include "TrainingSim.hpp"
+
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+
+struct ToolEntry {
+    std::string_view Name;
+    std::string_view Usage;
+    int (*Run)(ToolArgs);
+};
+
+static const ToolEntry ToolList[] = {
+    {"quantize", "quantize [checkpoint] [scenarios]    Int8 controller: calibration, closed-loop check and throughput.", QuantizeTool},
+    {"export", "export [checkpoint] [name] [directory]    Standalone constexpr C++ header of the best controller, plus a compile-time check.", ExportTool},
+    {"jit", "jit [checkpoint] [inputs]    Checks the x86-64 JIT against EvaluateNetwork and reports compile cost vs evaluation savings.", JitTool},
+    {"kernel-bench", "kernel-bench [max hidden] [batch]    Sweeps hidden layer sizes and reports FLOP/s of the layer kernels against the measured peak.", KernelBenchTool},
+    {"policy-field", "policy-field [checkpoint] [output .bin|.csv] [axes] [steps]    Evaluates the controller over a grid of drone states (axes like offset-x,angle:-1:1) in parallel.", PolicyFieldTool},
+    {"distill", "distill [checkpoint] [hidden1] [hidden2] [output] [epochs]    Trains a smaller student network to imitate the controller and checks it closed-loop.", DistillTool},
+    {"prune", "prune [checkpoint] [output] [tolerance %] [scenarios]    Magnitude-prunes the best controller as far as its closed-loop penalty allows.", PruneTool},
+    {"finetune", "finetune [checkpoint] [output] [steps] [scenarios]    Checks the autodiff penalty gradient and polishes the best controller with it, compared to the GA.", FineTuneTool},
+    {"reproduce-bench", "reproduce-bench [children] [repeats]    Times crossover and mutation kernels against the old per-child path, for several genome sizes.", ReproduceBenchTool},
+    {"heading-check", "heading-check [checkpoint] [scenarios]    Bounds the drift of the incrementally rotated heading against sin/cos of the angle and times both steps.", HeadingCheckTool},
+    {"vecmath", "vecmath [samples]    Max ulp error of the SIMD sin/cos/sqrt/wrap/log against libm over the simulation ranges, and their throughput.", VectorMathTool},
+    {"integrator-study", "integrator-study [checkpoint] [scenarios] [drones]    Error, cost and rank agreement of each integrator, timestep and control rate against a fine RK4 reference.", IntegratorStudyTool},
+    {"run-hash", "run-hash [generations] [seed]    Trains from a seed and prints a hash of the population per generation, to check runs are bit-identical.", RunHashTool},
+    {"rng-bench", "rng-bench [count]    Throughput of the scalar and batch random generators and samplers, plus statistical checks of the batch outputs.", RngBenchTool},
+    {"pool-bench", "pool-bench [tasks] [max threads]    Throughput of the thread pool schedulers on many tiny tasks, submitted from outside and inside the pool.", PoolBenchTool},
+    {"pin-bench", "pin-bench [generations] [cpu list]    Training generations per second with the workers unpinned and pinned compact, scatter or to a CPU list like 0-3,8.", PinBenchTool},
+};
+
+const char* ToolArg(ToolArgs args, size_t index, const char* fallback) {
+    if (index >= args.size()) return fallback;
+    return args[index];
+}
+
+int ToolArgInt(ToolArgs args, size_t index, int fallback) {
+    if (index >= args.size()) return fallback;
+    return std::atoi(args[index]);
+}
+
+bool LoadCheckpointBest(const char* fileName, Drone& out) {
+    TrainingSim training;
+    if (!training.LoadFromFile(fileName)) return false;
+
+    out = training.Drones[0];
+    return true;
+}
+
+FP MeanScenarioPenalty(const ControlNetwork& net, const std::vector<Scenario>& scenarios, std::vector<std::array<FP, InputSize>>* inputLog) {
+    Drone drone {net};
+    FP penalty = 0.0;
+    for (auto& scenario : scenarios) penalty += FlyScenario(drone, scenario, false, inputLog).Penalty / scenarios.size();
+    return penalty;
+}
+
+uint64_t PopulationHash(const TrainingSim& training) {
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&] (FP value) {
+        hash = (hash ^ std::bit_cast<uint64_t>(value)) * 0x100000001b3;
+    };
+
+    for (auto& drone : training.Drones) {
+        for (FP gene : drone.Brain.GetGenome()) add(gene);
+        add(drone.TrainingScore);
+    }
+    return hash;
+}
+
+static void PrintUsage() {
+    std::cout << "Usage: scptools <tool> [args...]\n\n";
+    for (auto& tool : ToolList) {
+        std::cout << "    " << tool.Usage << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::string_view name = argv[1];
+
+    for (auto& tool : ToolList) {
+        if (tool.Name == name) {
+            return tool.Run(ToolArgs(argv + 2, argc - 2));
+        }
+    }
+
+    std::cerr << "Unknown tool '" << name << "'.\n\n";
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "Drone.hpp"
+#include "Scenario.hpp"
+#include "Util.hpp"
+
+// Each tool receives the arguments that follow its name and returns the process exit code.
+using ToolArgs = std::span<char*>;
+
+// Returns argument `index` or `fallback` when it was not given.
+const char* ToolArg(ToolArgs args, size_t index, const char* fallback);
+int ToolArgInt(ToolArgs args, size_t index, int fallback);
+
+// Loads the best drone (first of the population) from a checkpoint file.
+bool LoadCheckpointBest(const char* fileName, Drone& out);
+
+// Mean closed-loop penalty of `net` over `scenarios`. Every network input is appended to `inputLog` if given.
+FP MeanScenarioPenalty(const ControlNetwork& net, const std::vector<Scenario>& scenarios, std::vector<std::array<FP, InputSize>>* inputLog = nullptr);
+
+// Nanoseconds per item of `func`, which processes `count` items, over `repeats` calls.
+template <class F>
+double NanosPerItem(size_t count, int repeats, const F& func) {
+    double seconds = MeasureSeconds([&] {
+        for (int r = 0; r < repeats; r++) func();
+    });
+    return seconds * 1e9 / ((double) count * repeats);
+}
+
+constexpr int ToolThroughputRepeats = 20;
+
+// Nanoseconds per evaluation of `controller` over `inputs`, repeated `ToolThroughputRepeats` times. The outputs are
+// summed into `checksum` so the evaluations are not optimized away.
+template <class C>
+double NanosPerEvaluation(const C& controller, const std::vector<std::array<FP, InputSize>>& inputs, FP& checksum) {
+    return NanosPerItem(inputs.size(), ToolThroughputRepeats, [&] {
+        for (auto& input : inputs) {
+            auto out = controller.EvaluateNetwork(input);
+            checksum += out[0] + out[1];
+        }
+    });
+}
+
+struct TrainingSim;
+
+// FNV-1a over the bits of every genome and score, in population order.
+uint64_t PopulationHash(const TrainingSim& training);
+
+int QuantizeTool(ToolArgs args);
+int ExportTool(ToolArgs args);
+int JitTool(ToolArgs args);
+int KernelBenchTool(ToolArgs args);
+int PolicyFieldTool(ToolArgs args);
+int DistillTool(ToolArgs args);
+int PruneTool(ToolArgs args);
+int FineTuneTool(ToolArgs args);
+int ReproduceBenchTool(ToolArgs args);
+int HeadingCheckTool(ToolArgs args);
+int VectorMathTool(ToolArgs args);
+int IntegratorStudyTool(ToolArgs args);
+int RunHashTool(ToolArgs args);
+int RngBenchTool(ToolArgs args);
+int PoolBenchTool(ToolArgs args);
+int PinBenchTool(ToolArgs args);
@@ -0,0 +1,189 @@
+#include "Tools.hpp"
+#include "Config.hpp"
+#include "Vec2xN.hpp"
+#include "VectorMath.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static constexpr int VectorMathRepeats = 50;
+
+// Largest absolute error accepted from `Vec2xN::Rotated`, which goes through `VectorSinCos` instead of libm.
+static constexpr FP Vec2xNRotationTolerance = 1e-12;
+
+// Distance in units in the last place of `expected`.
+static double UlpError(FP value, FP expected) {
+    if (value == expected) return 0.0;
+    FP magnitude = std::abs(expected);
+    FP ulp = std::nextafter(magnitude, INFINITY) - magnitude;
+    return std::abs(value - expected) / ulp;
+}
+
+struct VectorMathError {
+    double MaxUlp = 0.0;
+    double MaxAbs = 0.0;
+    long Mismatches = 0;
+
+    void Add(FP value, FP expected) {
+        MaxUlp = std::max(MaxUlp, UlpError(value, expected));
+        MaxAbs = std::max<double>(MaxAbs, std::abs(value - expected));
+        if (std::bit_cast<uint64_t>(value) != std::bit_cast<uint64_t>(expected)) Mismatches++;
+    }
+};
+
+static void PrintError(const char* name, const char* range, const VectorMathError& error) {
+    std::cout << std::setw(16) << name << std::setw(22) << range << std::scientific << std::setprecision(2);
+    std::cout << std::setw(14) << error.MaxUlp << std::setw(14) << error.MaxAbs << std::setw(12) << error.Mismatches << "\n";
+}
+
+template <VectorAccuracy Accuracy>
+static void CheckSinCos(const char* name, const char* range, const std::vector<FP>& x) {
+    std::vector<FP> s(x.size()), c(x.size());
+    VectorSinCos<Accuracy>(x, s, c);
+
+    VectorMathError sinError, cosError;
+    for (size_t i = 0; i < x.size(); i++) {
+        sinError.Add(s[i], std::sin(x[i]));
+        cosError.Add(c[i], std::cos(x[i]));
+    }
+
+    PrintError((std::string(name) + " sin").c_str(), range, sinError);
+    PrintError((std::string(name) + " cos").c_str(), range, cosError);
+}
+
+// `Vec2xN` against `Vec2`, lane by lane: `v` holds (xs[j], ys[j]), `w` the same points in reverse, `scales` one
+// scalar per batch. Returns the errors of the arithmetic operators and `Mag`, and of `Rotated`.
+static std::pair<VectorMathError, VectorMathError> CheckVec2xN(const std::vector<FP>& xs, const std::vector<FP>& ys, const std::vector<FP>& angles, const std::vector<FP>& scales) {
+    VectorMathError exact, rotated;
+    size_t n = xs.size();
+
+    for (size_t first = 0; first + SimdWidth <= n; first += SimdWidth) {
+        Vec2xN v, w;
+        FPVec angle;
+        for (int i = 0; i < SimdWidth; i++) {
+            size_t j = first + i;
+            v.SetLane(i, {xs[j], ys[j]});
+            w.SetLane(i, {xs[n - 1 - j], ys[n - 1 - j]});
+            angle[i] = angles[j];
+        }
+        FP s = scales[first / SimdWidth];
+
+        Vec2xN sum = v + w, difference = v - w, scaled = v * s, divided = v / s, negated = -v, turned = v.Rotated(angle);
+        FPVec mag = v.Mag();
+
+        for (int i = 0; i < SimdWidth; i++) {
+            Vec2 a = v.Lane(i), b = w.Lane(i);
+            auto add = [&exact] (const Vec2& value, const Vec2& expected) {
+                exact.Add(value.x, expected.x);
+                exact.Add(value.y, expected.y);
+            };
+
+            add(sum.Lane(i), a + b);
+            add(difference.Lane(i), a - b);
+            add(scaled.Lane(i), a * s);
+            add(divided.Lane(i), a / s);
+            add(negated.Lane(i), -a);
+            exact.Add(mag[i], a.Mag());
+
+            Vec2 expected = a.Rotated(angles[first + i]);
+            rotated.Add(turned.Lane(i).x, expected.x);
+            rotated.Add(turned.Lane(i).y, expected.y);
+        }
+    }
+
+    return {exact, rotated};
+}
+
+int VectorMathTool(ToolArgs args) {
+    int samples = ToolArgInt(args, 0, 1'000'000);
+
+    std::mt19937_64 gen {7};
+    auto uniform = [&] (FP a, FP b) {
+        std::uniform_real_distribution<FP> dist {a, b};
+        std::vector<FP> v(samples);
+        for (auto& x : v) x = dist(gen);
+        return v;
+    };
+
+    // Ranges the simulation produces: wrapped angles, the per-step angle change, angles of a drone spinning for a
+    // whole flight before they are wrapped, speeds and distances under the square root of the penalty.
+    auto angles = uniform(-2.0 * std::numbers::pi, 2.0 * std::numbers::pi);
+    auto deltas = uniform(-0.5, 0.5);
+    auto spins = uniform(-100.0, 100.0);
+    auto squares = uniform(0.0, 1000.0);
+    auto uniforms = uniform(0x1p-53, 1.0);
+
+    std::cout << "Error against libm over " << samples << " samples per range\n\n";
+    std::cout << std::setw(16) << "function" << std::setw(22) << "range" << std::setw(14) << "max ulp" << std::setw(14) << "max abs" << std::setw(12) << "!= libm" << "\n";
+
+    CheckSinCos<VectorAccuracy::Full>("full", "[-2pi, 2pi]", angles);
+    CheckSinCos<VectorAccuracy::Full>("full", "[-100, 100]", spins);
+    CheckSinCos<VectorAccuracy::Medium>("medium", "[-2pi, 2pi]", angles);
+    CheckSinCos<VectorAccuracy::Fast>("fast", "[-2pi, 2pi]", angles);
+    CheckSinCos<VectorAccuracy::Full>("full", "[-0.5, 0.5]", deltas);
+
+    std::vector<FP> out(samples);
+    VectorMathError sqrtError, wrapError, logError;
+
+    VectorApply(squares, out, VectorSqrt);
+    for (int i = 0; i < samples; i++) sqrtError.Add(out[i], std::sqrt(squares[i]));
+    PrintError("sqrt", "[0, 1000]", sqrtError);
+
+    VectorApply(spins, out, VectorWrapAngle);
+    for (int i = 0; i < samples; i++) wrapError.Add(out[i], std::fmod(spins[i], 2.0 * std::numbers::pi));
+    PrintError("wrap (fmod)", "[-100, 100]", wrapError);
+
+    VectorApply(uniforms, out, VectorLog);
+    for (int i = 0; i < samples; i++) logError.Add(out[i], std::log(uniforms[i]));
+    PrintError("log", "(0, 1]", logError);
+
+    // Points as far out as the arena, against `Vec2` rather than libm.
+    auto [vec2Error, rotationError] = CheckVec2xN(spins, uniform(-100.0, 100.0), angles, uniform(0.5, 2.0));
+    PrintError("Vec2xN ops, mag", "[-100, 100]^2", vec2Error);
+    PrintError("Vec2xN rotated", "[-100, 100]^2", rotationError);
+
+    std::cout << "\nThroughput, ns per value, single thread\n\n" << std::fixed << std::setprecision(2);
+
+    FP checksum = 0.0;
+    std::vector<FP> s(samples), c(samples);
+
+    auto row = [&] (const char* name, double libmNanos, double vectorNanos) {
+        std::cout << std::setw(16) << name << std::setw(12) << libmNanos << " libm" << std::setw(12) << vectorNanos << " vector";
+        std::cout << std::setw(10) << libmNanos / vectorNanos << "x\n";
+        checksum += s[samples / 2] + c[samples / 3] + out[samples / 4];
+    };
+
+    double libmSinCos = NanosPerItem(samples, VectorMathRepeats, [&] {
+        for (int i = 0; i < samples; i++) {
+            s[i] = std::sin(angles[i]);
+            c[i] = std::cos(angles[i]);
+        }
+    });
+    row("sincos full", libmSinCos, NanosPerItem(samples, VectorMathRepeats, [&] { VectorSinCos<VectorAccuracy::Full>(angles, s, c); }));
+    row("sincos medium", libmSinCos, NanosPerItem(samples, VectorMathRepeats, [&] { VectorSinCos<VectorAccuracy::Medium>(angles, s, c); }));
+    row("sincos fast", libmSinCos, NanosPerItem(samples, VectorMathRepeats, [&] { VectorSinCos<VectorAccuracy::Fast>(angles, s, c); }));
+
+    double libmSqrt = NanosPerItem(samples, VectorMathRepeats, [&] {
+        for (int i = 0; i < samples; i++) out[i] = std::sqrt(squares[i]);
+    });
+    row("sqrt", libmSqrt, NanosPerItem(samples, VectorMathRepeats, [&] { VectorApply(squares, out, VectorSqrt); }));
+
+    double libmWrap = NanosPerItem(samples, VectorMathRepeats, [&] {
+        for (int i = 0; i < samples; i++) out[i] = std::fmod(spins[i], 2.0 * std::numbers::pi);
+    });
+    row("wrap", libmWrap, NanosPerItem(samples, VectorMathRepeats, [&] { VectorApply(spins, out, VectorWrapAngle); }));
+
+    double libmLog = NanosPerItem(samples, VectorMathRepeats, [&] {
+        for (int i = 0; i < samples; i++) out[i] = std::log(uniforms[i]);
+    });
+    row("log", libmLog, NanosPerItem(samples, VectorMathRepeats, [&] { VectorApply(uniforms, out, VectorLog); }));
+
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    bool vec2Matches = vec2Error.Mismatches == 0 && rotationError.MaxAbs < Vec2xNRotationTolerance;
+    return wrapError.Mismatches == 0 && sqrtError.Mismatches == 0 && vec2Matches ? 0 : 1;
+}